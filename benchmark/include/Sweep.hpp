@@ -0,0 +1,79 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_BENCHMARK_SWEEP_HPP_
+#define IntelliStream_BENCHMARK_SWEEP_HPP_
+
+#include <BS_thread_pool.hpp>
+#include <cstddef>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <Amm/Bamm.hpp>
+#include <Utils/Config.hpp>
+#include <Utils/Meter/AbstractEnergyMeter.hpp>
+#include <Utils/UtilityFunctions.hpp>
+
+// Runs the strategies in the bins of a config over a grid of threads, p, l,
+// beta, and leading rows and columns of x and y, for strong and weak scaling
+// curves.
+//
+// Every point of the grid is run config.warmups times untimed, then
+// config.repetitions times timed. The results are rewritten to
+// config.sweepPath after each point, so an interrupted sweep keeps the points
+// it finished.
+class Sweep {
+public:
+  // A pool of n threads
+  typedef std::function<BS::thread_pool_ptr(size_t)> PoolFactory;
+
+  struct Row {
+    std::string strategy;
+    size_t t, p, l;
+    GAMM::scalar_t beta;
+    size_t xRows, yRows, cols;
+    double medianMs, p95Ms, minMs;
+    // Spectral norm of the difference from the exact product
+    double error;
+    // Median over the repetitions, when energy is measured
+    std::optional<double> energyJ;
+  };
+
+  // The sketches run pinned to cpu, if given
+  Sweep(const GAMM::Config &config,
+        std::optional<GAMM::EnergyMeterPtr> energyMeter, PoolFactory makePool,
+        std::optional<size_t> cpu = {})
+      : config{config}, energyMeter{std::move(energyMeter)},
+        makePool{std::move(makePool)}, cpu{cpu} {}
+
+  // Returns false if the results could not be written
+  bool run(GAMM::MatrixRef x, GAMM::MatrixRef y);
+
+  const std::vector<Row> &getRows() const noexcept { return rows; }
+
+  // As CSV if path ends in .csv, and as a JSON array otherwise
+  static bool write(const std::string &path, const std::vector<Row> &rows);
+
+private:
+  struct Strategy {
+    std::string name;
+    size_t t, p, l;
+    GAMM::scalar_t beta;
+    std::function<GAMM::BammUPtr()> make;
+  };
+
+  // The strategies of the bins for t threads. Single only runs for the first
+  // number of threads of the sweep, as it does not depend on it
+  std::vector<Strategy> strategies(size_t t, size_t l,
+                                   GAMM::scalar_t beta) const;
+  Row measure(const Strategy &strategy, GAMM::MatrixRef x, GAMM::MatrixRef y,
+              const GAMM::Matrix &z) const;
+
+  const GAMM::Config &config;
+  std::optional<GAMM::EnergyMeterPtr> energyMeter;
+  PoolFactory makePool;
+  std::optional<size_t> cpu;
+  std::vector<Row> rows;
+};
+#endif
@@ -6,26 +6,48 @@
  * We use this as the entry point for benchmarking.
  */
 #include <BS_thread_pool.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <functional>
 #include <iomanip>
 #include <memory>
 #include <optional>
+#include <sstream>
 
+#include <Amm/AutoBamm.hpp>
 #include <Amm/Bamm.hpp>
 #include <Amm/CombinedParallel.hpp>
 #include <Amm/InterParallel.hpp>
 #include <Amm/IntraParallel.hpp>
+#include <Amm/OutOfCore.hpp>
 #include <Amm/Single.hpp>
+#include <Amm/SketchCache.hpp>
+#include <Utils/ColumnBlockReader.hpp>
 #include <Utils/Config.hpp>
 #include <Utils/Logger.hpp>
+#include <Utils/MatrixFile.hpp>
 #include <Utils/Meter/AbstractEnergyMeter.hpp>
 #include <Utils/Meter/JetsonEnergyMeter.hpp>
+#include <Utils/Meter/PhaseEnergy.hpp>
+#include <Utils/Meter/PerfCounterGroup.hpp>
+#include <Utils/Meter/RaplEnergyMeter.hpp>
+#include <Utils/Numa.hpp>
+#include <Utils/Tracer.hpp>
 #include <Utils/UtilityFunctions.hpp>
 
+#include "Sweep.hpp"
+
+// Sketches x and y with a strategy, whether they are in memory or read out of
+// core
+typedef std::function<GAMM::Bamm::result(GAMM::Bamm &)> Sketcher;
+
 void runFunction(std::string_view name, GAMM::BammUPtr bamm,
-                 const GAMM::MatrixPtr &x, const GAMM::MatrixPtr &y,
-                 const GAMM::Matrix &z,
+                 const Sketcher &sketch, const GAMM::Matrix &z, size_t d,
+                 const std::optional<GAMM::SketchCache> &cache,
                  std::optional<GAMM::EnergyMeterPtr> energyMeter,
-                 const std::optional<std::string> &energyCSVPath);
+                 std::optional<size_t> cpu, const GAMM::Config &config,
+                 size_t p = 1);
 
 int main(int argc, char **argv) {
   // Setup Logs.
@@ -35,25 +57,122 @@ int main(int argc, char **argv) {
 
   INTELLI_INFO(config);
 
-  auto res = config.loadMatrices();
-  if (!res.has_value()) {
-    INTELLI_FATAL_ERROR("Error loading matrices in config. " << argc << argv);
-    return 1;
+  if (config.tracePath.has_value()) {
+    GAMM::Tracer::enable(config.tracePath.value());
   }
 
-  auto [x, y] = res.value();
+  std::optional<GAMM::Config::matrices> matrices;
+  std::optional<GAMM::ColumnBlockReaderUPtr> xReader, yReader;
+  std::optional<GAMM::SparseMatrix> xSparse, ySparse;
+  std::optional<GAMM::SketchCache> cache;
+  Sketcher sketch;
+  GAMM::Matrix z;
+  size_t mx, my, d;
 
-  INTELLI_INFO("Loaded matrices x(" << x->rows() << ", " << x->cols()
-                                    << ") and y(" << y->rows() << ", "
-                                    << y->cols() << ')');
+  BS::timer tmr;
 
-  INTELLI_INFO("x:\n" << (x->block<2, 2>(0, 0)));
-  INTELLI_INFO("y:\n" << (y->block<2, 2>(0, 0)));
+  if (config.blockCols == 0) {
+    tmr.start();
+    matrices = config.loadMatrices();
+    tmr.stop();
+    if (!matrices.has_value()) {
+      INTELLI_FATAL_ERROR("Error loading matrices in config. " << argc << argv);
+      return 1;
+    }
 
-  BS::timer tmr;
-  tmr.start();
-  const GAMM::Matrix z = *x * y->transpose();
-  tmr.stop();
+    const auto x = matrices->x->map();
+    const auto y = matrices->y->map();
+
+    INTELLI_INFO("Loaded matrices x("
+                 << x.rows() << ", " << x.cols() << ") and y(" << y.rows()
+                 << ", " << y.cols() << ')'
+                 << (matrices->x->isMapped() ? " (mapped)" : ""));
+
+    if (config.synthetic.has_value()) {
+      std::cout << "\033[0;32mGenerate " << tmr.ms() << "ms\033[0m\n";
+    } else {
+      // For mapped files this only covers mapping them, their pages are read
+      // when they are first used
+      auto loadMB = (std::filesystem::file_size(config.x) +
+                     std::filesystem::file_size(config.y)) /
+                    1e6;
+      std::cout << "\033[0;32mLoad " << tmr.ms() << "ms, "
+                << loadMB / std::max<double>(tmr.ms(), 1) * 1e3
+                << "MB/s\033[0m\n";
+    }
+
+    INTELLI_INFO("x:\n" << (x.block<2, 2>(0, 0)));
+    INTELLI_INFO("y:\n" << (y.block<2, 2>(0, 0)));
+
+    tmr.start();
+    z = x * y.transpose();
+    tmr.stop();
+
+    sketch = [x, y](GAMM::Bamm &bamm) { return bamm.sketch(x, y); };
+    if (config.sparse) {
+      xSparse = x.sparseView();
+      ySparse = y.sparseView();
+      INTELLI_INFO("Sparse x has " << xSparse->nonZeros() << " and y has "
+                                   << ySparse->nonZeros() << " non-zeros");
+      sketch = [&xSparse, &ySparse](GAMM::Bamm &bamm) {
+        return bamm.sketch(xSparse.value(), ySparse.value());
+      };
+    }
+    if (config.sketchCache.has_value()) {
+      BS::thread_pool pool(std::max<size_t>(config.t, 2) - 1);
+      tmr.start();
+      cache.emplace(config.sketchCache.value(), x, y, &pool);
+      tmr.stop();
+      std::cout << "\033[0;32mHash " << tmr.ms() << "ms\033[0m\n";
+    }
+    mx = x.rows();
+    my = y.rows();
+    d = x.cols();
+  } else {
+    if (config.sketchCache.has_value()) {
+      INTELLI_WARNING("The sketch cache is only used with inputs in memory");
+    }
+    if (config.synthetic.has_value()) {
+      INTELLI_WARNING("Synthetic inputs are generated in memory, reading "
+                      << config.x << " and " << config.y << " instead");
+    }
+
+    xReader = GAMM::ColumnBlockReader::open(config.x);
+    yReader = GAMM::ColumnBlockReader::open(config.y);
+    if (!xReader.has_value() || !yReader.has_value()) {
+      INTELLI_FATAL_ERROR("Error opening matrices in config. " << argc << argv);
+      return 1;
+    }
+
+    auto &x = *xReader.value();
+    auto &y = *yReader.value();
+    INTELLI_INFO("Streaming matrices x(" << x.rows() << ", " << x.cols()
+                                         << ") and y(" << y.rows() << ", "
+                                         << y.cols() << ") in blocks of "
+                                         << config.blockCols << " columns");
+
+    tmr.start();
+    auto exact = GAMM::OutOfCore::exactProduct(x, y, config.blockCols,
+                                              config.prefetchDepth);
+    tmr.stop();
+    if (!exact.has_value()) {
+      INTELLI_FATAL_ERROR("Error reading matrices in config. " << argc << argv);
+      return 1;
+    }
+    z = std::move(exact.value());
+
+    sketch = [&x, &y, &config](GAMM::Bamm &bamm) {
+      auto res = GAMM::OutOfCore(bamm, config.blockCols, config.prefetchDepth,
+                                 config.checkpointPath,
+                                 std::chrono::seconds{config.checkpointInterval})
+                     .sketch(x, y);
+      INTELLI_ASSERT(res.has_value(), "Error reading matrices out of core");
+      return res.value();
+    };
+    mx = x.rows();
+    my = y.rows();
+    d = x.cols();
+  }
 
   std::cout << "\033[0;32mLib-MM " << tmr.ms() << "ms\033[0m\n";
   INTELLI_INFO("z:\n" << (z.block<2, 2>(0, 0)));
@@ -64,30 +183,78 @@ int main(int argc, char **argv) {
     if (GAMM::JetsonEnergyMeter::canBeUsed()) {
       INTELLI_INFO("Using Jetson Energy Meter");
       energyMeter = std::make_shared<GAMM::JetsonEnergyMeter>();
+    } else if (GAMM::RaplEnergyMeter::canBeUsed()) {
+      INTELLI_INFO("Using RAPL Energy Meter");
+      energyMeter = std::make_shared<GAMM::RaplEnergyMeter>();
     } else {
       INTELLI_FATAL_ERROR("No energy meter");
       return 1;
     }
   }
 
+  const auto topology = GAMM::NumaTopology::discover();
+  std::optional<GAMM::NumaTopology::Placement> placement{};
+
+  if (config.pinThreads.has_value()) {
+    placement = GAMM::NumaTopology::parsePlacement(config.pinThreads.value());
+    if (!placement.has_value()) {
+      INTELLI_FATAL_ERROR("Unknown thread placement "
+                          << config.pinThreads.value());
+      return 1;
+    }
+    INTELLI_INFO("Pinning threads (" << config.pinThreads.value() << ") on "
+                                     << topology);
+  }
+
+  // The main thread takes the first cpu of every placement, and the threads of
+  // the pools the following ones
+  std::optional<size_t> mainCpu{};
+  if (placement.has_value()) {
+    mainCpu = topology.placement(1, placement.value())[0];
+  }
+
+  // A pool of n threads, pinned when requested
+  auto makePool = [&](size_t n) {
+    auto pool = std::make_shared<BS::thread_pool>(n);
+    if (placement.has_value()) {
+      GAMM::NumaTopology::pinPool(*pool,
+                                  topology.placement(n + 1, placement.value()));
+    }
+    return pool;
+  };
+
+  const auto partitioning = config.balancedPartitions
+                                ? GAMM::ColumnPartitioner::Mode::Balanced
+                                : GAMM::ColumnPartitioner::Mode::Even;
+
+  if (config.sweepPath.has_value()) {
+    if (!matrices.has_value()) {
+      INTELLI_FATAL_ERROR("Sweeps need x and y in memory, not out of core");
+      return 1;
+    }
+    Sweep sweep{config, energyMeter, makePool, mainCpu};
+    return sweep.run(matrices->x->map(), matrices->y->map()) ? 0 : 1;
+  }
+
   if (config.bins.single) {
     runFunction("single-threaded",
-                std::make_unique<GAMM::Single>(config.l, config.beta), x, y, z,
-                energyMeter, config.energyCSVPath);
+                std::make_unique<GAMM::Single>(config.l, config.beta),
+                sketch, z, d, cache, energyMeter, mainCpu, config);
   }
 
   if (config.bins.intra) {
-    runFunction(
-        "intra-parallel",
-        std::make_unique<GAMM::IntraParallel>(config.l, config.beta, config.t),
-        x, y, z, energyMeter, config.energyCSVPath);
+    runFunction("intra-parallel",
+                std::make_unique<GAMM::IntraParallel>(
+                    config.l, config.beta, makePool(config.t - 1), config.t),
+                sketch, z, d, cache, energyMeter, mainCpu, config);
   }
 
   if (config.bins.inter) {
-    runFunction(
-        "inter-parallel",
-        std::make_unique<GAMM::InterParallel>(config.l, config.beta, config.t),
-        x, y, z, energyMeter, config.energyCSVPath);
+    runFunction("inter-parallel",
+                std::make_unique<GAMM::InterParallel>(
+                    config.l, config.beta, makePool(config.t - 1), config.fanIn,
+                    partitioning),
+                sketch, z, d, cache, energyMeter, mainCpu, config, config.t);
   }
 
   if (config.bins.combined) {
@@ -96,33 +263,84 @@ int main(int argc, char **argv) {
       s += std::to_string(p);
       runFunction(s,
                   std::make_unique<GAMM::CombinedParallel>(
-                      config.l, config.beta, config.t, p),
-                  x, y, z, energyMeter, config.energyCSVPath);
+                      config.l, config.beta, makePool(config.t + p - 1), p,
+                      config.fanIn, partitioning),
+                  sketch, z, d, cache, energyMeter, mainCpu, config, p);
     }
   }
+
+  if (config.bins.autotune) {
+    auto bamm = std::make_unique<GAMM::AutoBamm>(
+        config.l, config.beta, config.t > 1 ? makePool(config.t - 1) : nullptr,
+        config.t, config.fanIn, partitioning, config.calibrationPath);
+    // Choosing up front calibrates outside of the timed region and names the run
+    std::ostringstream s;
+    s << "auto-" << bamm->choose(mx, my, d);
+    runFunction(s.str(), std::move(bamm), sketch, z, d, cache, energyMeter,
+                mainCpu, config);
+  }
 }
 
 void runFunction(std::string_view name, GAMM::BammUPtr bamm,
-                 const GAMM::MatrixPtr &x, const GAMM::MatrixPtr &y,
-                 const GAMM::Matrix &z,
+                 const Sketcher &sketch, const GAMM::Matrix &z, size_t d,
+                 const std::optional<GAMM::SketchCache> &cache,
                  std::optional<GAMM::EnergyMeterPtr> energyMeter,
-                 const std::optional<std::string> &energyCSVPath) {
+                 std::optional<size_t> cpu, const GAMM::Config &config,
+                 size_t p) {
 
   INTELLI_INFO("Running " << name << " with energyMeter? "
                           << energyMeter.has_value());
   if (energyMeter.has_value()) {
+    // Markers of the phases let their energy be told apart
+    bamm->getProfilePtr()->setMarkers(true);
     energyMeter.value()->startSampling();
   }
 
   std::optional<GAMM::AbstractEnergyMeter::Readings> energyReadings{};
 
   BS::timer tmr;
+  std::optional<GAMM::Bamm::result> cached{};
+
+  std::optional<GAMM::PerfCounterGroup> perf{};
+  std::optional<GAMM::PerfCounterGroup::Counts> perfCounts{};
+  if (config.perfCounters) {
+    perf.emplace();
+    if (!perf->start()) {
+      perf.reset();
+    }
+  }
+
+  const GAMM::SketchCache::Key key{config.l,
+                                   config.beta,
+                                   name,
+                                   config.t,
+                                   p,
+                                   config.fanIn,
+                                   config.balancedPartitions
+                                       ? GAMM::ColumnPartitioner::Mode::Balanced
+                                       : GAMM::ColumnPartitioner::Mode::Even};
+
+  // Only the run is pinned, so that the threads started before and after it
+  // (the energy sampler, the output pool, the next runs' pools) are not
+  std::optional<GAMM::NumaTopology::PinScope> pin{std::in_place, cpu};
   tmr.start();
-  auto z_amm = bamm->multiply(*x, *y);
+  if (cache.has_value()) {
+    cached = cache->get(key);
+  }
+  auto [bx, by] = cached.has_value() ? cached.value() : sketch(*bamm);
+  auto z_amm = std::make_shared<GAMM::Matrix>(*bx * by->transpose());
   tmr.stop();
+  pin.reset();
+
+  if (perf.has_value()) {
+    perfCounts = perf->stop();
+  }
 
   if (energyMeter.has_value()) {
     energyReadings = energyMeter.value()->stopSampling();
+    GAMM::PhaseEnergy::attribute(energyReadings.value(),
+                                 bamm->getProfile().getMarkers());
+    bamm->getProfilePtr()->setMarkers(false);
   }
 
   INTELLI_INFO(name << " z_amm:\n" << (z_amm->block<2, 2>(0, 0)));
@@ -132,16 +350,78 @@ void runFunction(std::string_view name, GAMM::BammUPtr bamm,
   auto err = GAMM::UtilityFunctions::spectralNorm(*z_amm);
 
   std::cout << "\033[0;32m" << std::setw(23) << name << ":  Time - "
-            << (tmr.ms()) << "ms;  \033[0m";
+            << (tmr.ms()) << "ms" << (cached.has_value() ? " (cached)" : "")
+            << ";  \033[0m";
+
+  if (cache.has_value() && !cached.has_value()) {
+    cache->put(key, {bx, by});
+  }
+
+  if (perfCounts.has_value()) {
+    using Event = GAMM::PerfCounterGroup::Event;
+    auto ipc = perfCounts->ipc();
+    if (ipc.has_value()) {
+      std::cout << "IPC - " << std::setprecision(3) << ipc.value() << ";  ";
+    }
+    if (perfCounts.value()[Event::CacheMisses].has_value()) {
+      std::cout << "LLC misses/col - " << std::setprecision(4)
+                << double(perfCounts.value()[Event::CacheMisses].value()) / d
+                << ";  ";
+    }
+    if (perfCounts.value()[Event::BranchMisses].has_value()) {
+      std::cout << "Branch misses/col - " << std::setprecision(4)
+                << double(perfCounts.value()[Event::BranchMisses].value()) / d
+                << ";  ";
+    }
+  }
 
   if (energyReadings.has_value()) {
-    if (energyCSVPath.has_value()) {
-      energyReadings.value().writeCSV(energyCSVPath.value().c_str());
+    if (config.energyCSVPath.has_value()) {
+      energyReadings.value().writeCSV(config.energyCSVPath.value().c_str());
     }
 
     std::cout << "Energy - " << std::setw(8) << std::setprecision(4)
               << (energyReadings.value().energyConsumed()) << "J;  ";
   }
 
+  const auto &load = bamm->getLoadProfile();
+  if (load.nworkers() > 0) {
+    std::cout << "Imbalance - " << std::setprecision(3) << load.imbalance()
+              << ";  Idle - " << std::setprecision(3)
+              << load.idleFraction() * 100 << "%;  ";
+  }
+
+  if (config.outputPath.has_value()) {
+    auto path = std::filesystem::path{config.outputPath.value()} /
+                (std::string{name} + ".gmat");
+    BS::thread_pool pool(std::max<size_t>(config.t, 2) - 1);
+
+    tmr.start();
+    auto written = GAMM::MatrixFile::writeGmatProduct(
+        path.string(), *bx, *by, config.tileCols, &pool);
+    tmr.stop();
+
+    if (written) {
+      std::cout << "Output - " << tmr.ms() << "ms;  ";
+    }
+  }
+
   std::cout << "Error - " << std::setprecision(4) << err << std::endl;
+
+  if (config.printPhases) {
+    std::cout << bamm->getProfile();
+    if (load.nworkers() > 0) {
+      std::cout << load;
+    }
+
+    if (energyReadings.has_value() && !energyReadings->columns.empty()) {
+      std::cout << "Energy by phase and level -";
+      for (const auto &[column, energyJ] :
+           GAMM::PhaseEnergy::totals(energyReadings.value())) {
+        std::cout << " " << column << " " << std::setprecision(4) << energyJ
+                  << "J;";
+      }
+      std::cout << std::endl;
+    }
+  }
 }
@@ -0,0 +1,105 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+/**
+ * @brief Rewrites matrix files in the .gmat format.
+ * Every .dat, .cdat, .npy or .mtx file given, or found in a given directory,
+ * is written next to the original with the .gmat extension and then read back
+ * to check it.
+ */
+#include <BS_thread_pool.hpp>
+#include <algorithm>
+#include <boost/program_options.hpp>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <Utils/Logger.hpp>
+#include <Utils/MappedMatrix.hpp>
+#include <Utils/MatrixFile.hpp>
+
+namespace fs = std::filesystem;
+namespace po = boost::program_options;
+
+bool convertFile(const fs::path &input, bool columnNorms,
+                 BS::thread_pool &pool) {
+  auto output = input;
+  output.replace_extension(".gmat");
+  if (output == input) {
+    std::cerr << input << " is already a .gmat file\n";
+    return false;
+  }
+
+  auto matrix = GAMM::MappedMatrix::open(input.string(), false, &pool);
+  if (!matrix.has_value()) {
+    std::cerr << "Failed to read " << input << '\n';
+    return false;
+  }
+
+  auto map = matrix.value()->map();
+  if (!GAMM::MatrixFile::writeGmat(output.string(), map, columnNorms)) {
+    std::cerr << "Failed to write " << output << '\n';
+    return false;
+  }
+
+  auto written = GAMM::MappedMatrix::open(output.string(), true);
+  if (!written.has_value() || written.value()->map() != map) {
+    std::cerr << "Verification of " << output << " failed\n";
+    return false;
+  }
+
+  std::cout << input.string() << " -> " << output.string() << " ("
+            << map.rows() << ", " << map.cols() << ")\n";
+  return true;
+}
+
+int main(int argc, char **argv) {
+  setupLogging("convert.log", LOG_INFO);
+
+  // clang-format off
+  po::options_description desc("Usage: gmat-convert [options] <file or directory>...");
+  desc.add_options()
+    ("help", "produce help message")
+    ("no-norms", "do not store the per-column norms")
+    ("input", po::value<std::vector<std::string>>(), "files or directories to convert");
+  // clang-format on
+
+  po::positional_options_description positional;
+  positional.add("input", -1);
+
+  po::variables_map vm;
+  po::store(po::command_line_parser(argc, argv)
+                .options(desc)
+                .positional(positional)
+                .run(),
+            vm);
+  po::notify(vm);
+
+  if (vm.count("help") || !vm.count("input")) {
+    std::cout << desc << "\n";
+    return vm.count("help") ? 0 : 1;
+  }
+
+  auto columnNorms = !vm.count("no-norms");
+  bool ok = true;
+  // Reading the inputs is split between the pool and the main thread
+  BS::thread_pool pool(std::max(std::thread::hardware_concurrency(), 2u) - 1);
+
+  for (const auto &input : vm["input"].as<std::vector<std::string>>()) {
+    if (!fs::is_directory(input)) {
+      ok &= convertFile(input, columnNorms, pool);
+      continue;
+    }
+
+    for (const auto &entry : fs::directory_iterator{input}) {
+      auto extension = entry.path().extension();
+      if (entry.is_regular_file() &&
+          (extension == ".dat" || extension == ".cdat" ||
+           extension == ".npy" || extension == ".mtx")) {
+        ok &= convertFile(entry.path(), columnNorms, pool);
+      }
+    }
+  }
+
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,221 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+/**
+ * @brief Microbenchmarks of the kernels a reduction is made of, so that a
+ * regression can be narrowed down to QR, pair generation, sorting, rotation
+ * generation, rotation application or the final product.
+ */
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <BS_thread_pool.hpp>
+#include <memory>
+
+#include <Svd/ParallelJTS.hpp>
+#include <Svd/SequentialJTS.hpp>
+#include <Utils/Logger.hpp>
+#include <Utils/UtilityFunctions.hpp>
+#include <Utils/ZeroedColumns.hpp>
+
+using namespace GAMM;
+
+// Exposes the protected kernels of the Jacobi SVD
+class Kernels : public SequentialJTS {
+public:
+  using AbstractJTS::ColumnPair;
+  using AbstractJTS::JacobiRotation;
+  using Svd::sortSingularValues;
+
+  void set(const Matrix &u, const Matrix &v, const DiagonalMatrix &sv) {
+    this->u = u;
+    this->v = v;
+    this->sv = sv;
+  }
+};
+
+// Runs one phase of ParallelJTS on all of its workers, as svdStep does
+class ParallelJTSPhases : public ParallelJTS {
+public:
+  using ParallelJTS::ParallelJTS;
+
+  void phase1() { run(&ParallelJTSPhases::workerTaskPhase1); }
+  void phase2() { run(&ParallelJTSPhases::workerTaskPhase2); }
+  void phase3() { run(&ParallelJTSPhases::workerTaskPhase3); }
+
+private:
+  void run(void (ParallelJTS::*phase)(size_t)) {
+    BS::multi_future<void> tasks(t - 1);
+    for (size_t i = 1; i < t; ++i) {
+      tasks[i - 1] = pool->submit([this, phase, i]() { (this->*phase)(i); });
+    }
+    (this->*phase)(0);
+    tasks.wait();
+  }
+};
+
+// Arguments are (rows, l)
+static void BM_Qr(benchmark::State &state) {
+  const Matrix a = Matrix::Random(state.range(0), state.range(1));
+  Matrix q, r{a.cols(), a.cols()};
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    q = a;
+    state.ResumeTiming();
+    UtilityFunctions::qr(q, r, true);
+    benchmark::DoNotOptimize(r.data());
+  }
+  state.SetItemsProcessed(state.iterations() * a.cols());
+}
+BENCHMARK(BM_Qr)
+    ->ArgsProduct({{256, 1024, 4096}, {32, 64, 128}})
+    ->ArgNames({"rows", "l"})
+    ->Unit(benchmark::kMicrosecond);
+
+// Arguments are (l)
+static void BM_SequentialSvdStep(benchmark::State &state) {
+  const Matrix a = Matrix::Random(state.range(0), state.range(0));
+  SequentialJTS svd;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    svd.startSvd(a);
+    state.ResumeTiming();
+    benchmark::DoNotOptimize(svd.svdStep());
+  }
+}
+BENCHMARK(BM_SequentialSvdStep)
+    ->Arg(32)
+    ->Arg(64)
+    ->Arg(128)
+    ->ArgName("l")
+    ->Unit(benchmark::kMicrosecond);
+
+// Arguments are (l, threads). Phase 1 generates and sorts the column pairs,
+// phase 2 generates the rotations and phase 3 applies them
+template <int Phase> static void BM_ParallelJTSPhase(benchmark::State &state) {
+  const Matrix a = Matrix::Random(state.range(0), state.range(0));
+  const size_t t = state.range(1);
+  // A pool of 0 threads would get one per hardware thread
+  ParallelJTSPhases svd{
+      std::make_shared<BS::thread_pool>(std::max<size_t>(t - 1, 1)), t};
+
+  svd.startSvd(a);
+  // The later phases work on the pairs and rotations found by the earlier
+  svd.phase1();
+  svd.phase2();
+
+  for (auto _ : state) {
+    if constexpr (Phase == 1) {
+      svd.phase1();
+    } else if constexpr (Phase == 2) {
+      svd.phase2();
+    } else {
+      svd.phase3();
+    }
+  }
+}
+BENCHMARK_TEMPLATE(BM_ParallelJTSPhase, 1)
+    ->ArgsProduct({{32, 64, 128}, {1, 2, 4}})
+    ->ArgNames({"l", "threads"})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ParallelJTSPhase, 2)
+    ->ArgsProduct({{32, 64, 128}, {1, 2, 4}})
+    ->ArgNames({"l", "threads"})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+BENCHMARK_TEMPLATE(BM_ParallelJTSPhase, 3)
+    ->ArgsProduct({{32, 64, 128}, {1, 2, 4}})
+    ->ArgNames({"l", "threads"})
+    ->Unit(benchmark::kMicrosecond)
+    ->UseRealTime();
+
+// Arguments are (rows)
+static void BM_JacobiRotationApply(benchmark::State &state) {
+  Matrix a = Matrix::Random(state.range(0), 2);
+  const Kernels::JacobiRotation rotation{
+      Kernels::ColumnPair{0, 1, a.col(0).dot(a.col(1))}, a};
+
+  // Rotations preserve norms, so a can be rotated over and over
+  for (auto _ : state) {
+    rotation.applyTo(a);
+    benchmark::DoNotOptimize(a.data());
+  }
+}
+BENCHMARK(BM_JacobiRotationApply)
+    ->Arg(32)
+    ->Arg(128)
+    ->Arg(1024)
+    ->ArgName("rows")
+    ->Unit(benchmark::kNanosecond);
+
+// Arguments are (l)
+static void BM_SortSingularValues(benchmark::State &state) {
+  const auto l = state.range(0);
+  const Matrix u = Matrix::Random(l, l);
+  const Matrix v = Matrix::Random(l, l);
+  DiagonalMatrix sv{l};
+  Kernels kernels;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    sv.diagonal() = Vector::Random(l).cwiseAbs();
+    kernels.set(u, v, sv);
+    state.ResumeTiming();
+    kernels.sortSingularValues();
+  }
+}
+BENCHMARK(BM_SortSingularValues)
+    ->Arg(32)
+    ->Arg(64)
+    ->Arg(128)
+    ->ArgName("l")
+    ->Unit(benchmark::kMicrosecond);
+
+// Arguments are (rows, l). Half of the columns are zero, as after a shrink
+static void BM_ZeroedColumns(benchmark::State &state) {
+  Matrix a = Matrix::Random(state.range(0), state.range(1));
+  for (long i = 0; i < a.cols(); i += 2) {
+    a.col(i).setZero();
+  }
+  ZeroedColumns zeroed;
+
+  for (auto _ : state) {
+    zeroed.fromMatrix(a);
+    while (zeroed.nzeroed() > 0) {
+      benchmark::DoNotOptimize(zeroed.getNextZeroed());
+    }
+  }
+}
+BENCHMARK(BM_ZeroedColumns)
+    ->ArgsProduct({{256, 4096}, {32, 64, 128}})
+    ->ArgNames({"rows", "l"})
+    ->Unit(benchmark::kMicrosecond);
+
+// Arguments are (rows, l). The product of the sketches, bx * by^T
+static void BM_SketchProduct(benchmark::State &state) {
+  const Matrix bx = Matrix::Random(state.range(0), state.range(1));
+  const Matrix by = Matrix::Random(state.range(0), state.range(1));
+  Matrix z{bx.rows(), by.rows()};
+
+  for (auto _ : state) {
+    z.noalias() = bx * by.transpose();
+    benchmark::DoNotOptimize(z.data());
+  }
+}
+BENCHMARK(BM_SketchProduct)
+    ->ArgsProduct({{256, 1024}, {32, 128}})
+    ->ArgNames({"rows", "l"})
+    ->Unit(benchmark::kMicrosecond);
+
+int main(int argc, char **argv) {
+  setupLogging("microbench.log", LOG_WARNING);
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+}
@@ -0,0 +1,279 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <Amm/AutoBamm.hpp>
+#include <Amm/CombinedParallel.hpp>
+#include <Amm/InterParallel.hpp>
+#include <Amm/IntraParallel.hpp>
+#include <Amm/Single.hpp>
+#include <Utils/Logger.hpp>
+#include <Utils/Numa.hpp>
+
+#include "Sweep.hpp"
+
+using namespace GAMM;
+
+template <typename T>
+static std::vector<T> orDefault(const std::vector<T> &list, T value) {
+  return list.empty() ? std::vector<T>{value} : list;
+}
+
+bool Sweep::run(MatrixRef x, MatrixRef y) {
+  const auto threads = orDefault(config.sweepThreads, config.t);
+  const auto ls = orDefault(config.sweepL, config.l);
+  const auto betas = orDefault(config.sweepBeta, config.beta);
+  const auto maxThreads = *std::max_element(threads.begin(), threads.end());
+  // By default the largest weak scaling point uses all of the columns
+  const auto colsList = orDefault(
+      config.sweepCols,
+      config.sweepWeak ? std::max<size_t>(x.cols() / maxThreads, 1)
+                       : size_t(x.cols()));
+  const auto rowsList =
+      orDefault(config.sweepRows, size_t(std::max(x.rows(), y.rows())));
+
+  // The exact product of the last slice of x and y
+  Matrix z;
+  size_t zRows{0}, zCols{0};
+
+  for (auto nrows : rowsList) {
+    size_t mx = std::min<size_t>(nrows, x.rows());
+    size_t my = std::min<size_t>(nrows, y.rows());
+
+    for (auto t : threads) {
+      for (auto ncols : colsList) {
+        size_t d = config.sweepWeak ? ncols * t : ncols;
+        if (d > size_t(x.cols())) {
+          INTELLI_WARNING("Only " << x.cols() << " columns, not " << d);
+          d = x.cols();
+        }
+
+        auto xs = x.topLeftCorner(mx, d);
+        auto ys = y.topLeftCorner(my, d);
+        if (zRows != nrows || zCols != d) {
+          z = xs * ys.transpose();
+          zRows = nrows;
+          zCols = d;
+        }
+
+        for (auto l : ls) {
+          for (auto beta : betas) {
+            for (const auto &strategy : strategies(t, l, beta)) {
+              rows.push_back(measure(strategy, xs, ys, z));
+
+              const auto &row = rows.back();
+              std::cout << "\033[0;32m" << std::setw(23) << row.strategy
+                        << ":  t " << row.t << ", p " << row.p << ", l "
+                        << row.l << ", beta " << row.beta << ", x(" << mx
+                        << ", " << d << "), y(" << my << ", " << d
+                        << ");  Time - " << row.medianMs << "ms;  \033[0m"
+                        << "Error - " << std::setprecision(4) << row.error
+                        << std::endl;
+
+              if (!write(config.sweepPath.value(), rows)) {
+                return false;
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+std::vector<Sweep::Strategy> Sweep::strategies(size_t t, size_t l,
+                                               scalar_t beta) const {
+  const auto partitioning = config.balancedPartitions
+                                ? ColumnPartitioner::Mode::Balanced
+                                : ColumnPartitioner::Mode::Even;
+  const auto fanIn = config.fanIn;
+  std::vector<Strategy> result;
+
+  const auto firstT = orDefault(config.sweepThreads, config.t).front();
+  if (config.bins.single && t == firstT) {
+    result.push_back({"single-threaded", 1, 1, l, beta,
+                      [=]() { return std::make_unique<Single>(l, beta); }});
+  }
+
+  if (config.bins.intra) {
+    result.push_back({"intra-parallel", t, 1, l, beta, [=, this]() {
+                        return std::make_unique<IntraParallel>(
+                            l, beta, makePool(t - 1), t);
+                      }});
+  }
+
+  if (config.bins.inter) {
+    result.push_back({"inter-parallel", t, t, l, beta, [=, this]() {
+                        return std::make_unique<InterParallel>(
+                            l, beta, makePool(t - 1), fanIn, partitioning);
+                      }});
+  }
+
+  if (config.bins.combined) {
+    std::vector<size_t> ps;
+    for (auto p : config.sweepP) {
+      if (p <= t) {
+        ps.push_back(p);
+      }
+    }
+    if (config.sweepP.empty()) {
+      for (size_t p = 1; p <= t; p *= 2) {
+        ps.push_back(p);
+      }
+    }
+
+    for (auto p : ps) {
+      result.push_back(
+          {"combined-parallel-" + std::to_string(p), t, p, l, beta,
+           [=, this]() {
+             return std::make_unique<CombinedParallel>(
+                 l, beta, makePool(t + p - 1), p, fanIn, partitioning);
+           }});
+    }
+  }
+
+  if (config.bins.autotune) {
+    const auto &calibrationPath = config.calibrationPath;
+    result.push_back({"auto", t, 0, l, beta, [=, this]() {
+                        return std::make_unique<AutoBamm>(
+                            l, beta, t > 1 ? makePool(t - 1) : nullptr, t,
+                            fanIn, partitioning, calibrationPath);
+                      }});
+  }
+
+  return result;
+}
+
+Sweep::Row Sweep::measure(const Strategy &strategy, MatrixRef x, MatrixRef y,
+                          const Matrix &z) const {
+  Row row{strategy.name,
+          strategy.t,
+          strategy.p,
+          strategy.l,
+          strategy.beta,
+          size_t(x.rows()),
+          size_t(y.rows()),
+          size_t(x.cols()),
+          0,
+          0,
+          0,
+          0,
+          {}};
+
+  auto bamm = strategy.make();
+
+  // Choosing up front calibrates outside of the timed runs and names the row
+  if (auto autoBamm = dynamic_cast<AutoBamm *>(bamm.get())) {
+    auto choice = autoBamm->choose(x.rows(), y.rows(), x.cols());
+    std::ostringstream s;
+    s << "auto-" << choice;
+    row.strategy = s.str();
+    row.p = choice.p;
+  }
+
+  for (size_t i = 0; i < config.warmups; ++i) {
+    const NumaTopology::PinScope pin{cpu};
+    bamm->sketch(x, y);
+  }
+
+  std::vector<double> times, energies;
+
+  for (size_t i = 0; i < std::max<size_t>(config.repetitions, 1); ++i) {
+    if (energyMeter.has_value()) {
+      energyMeter.value()->startSampling();
+    }
+
+    // Pinned after the energy sampler has started, which would inherit it
+    std::optional<NumaTopology::PinScope> pin{std::in_place, cpu};
+    // BS::timer only has whole milliseconds, too coarse for small sweeps
+    auto start = std::chrono::steady_clock::now();
+    auto [bx, by] = bamm->sketch(x, y);
+    Matrix zAmm = *bx * by->transpose();
+    std::chrono::duration<double, std::milli> elapsed =
+        std::chrono::steady_clock::now() - start;
+    pin.reset();
+
+    if (energyMeter.has_value()) {
+      energies.push_back(
+          energyMeter.value()->stopSampling().energyConsumed());
+    }
+    times.push_back(elapsed.count());
+
+    if (i + 1 == std::max<size_t>(config.repetitions, 1)) {
+      zAmm -= z;
+      row.error = UtilityFunctions::spectralNorm(zAmm);
+    }
+  }
+
+  auto median = [](std::vector<double> &values) {
+    std::sort(values.begin(), values.end());
+    auto n = values.size();
+    return n % 2 ? values[n / 2] : (values[n / 2 - 1] + values[n / 2]) / 2;
+  };
+
+  row.medianMs = median(times);
+  row.minMs = times.front();
+  // Nearest rank
+  row.p95Ms = times[size_t(std::ceil(0.95 * times.size())) - 1];
+  if (!energies.empty()) {
+    row.energyJ = median(energies);
+  }
+
+  return row;
+}
+
+bool Sweep::write(const std::string &path, const std::vector<Row> &rows) {
+  std::ofstream f(path, std::ios::out | std::ios::trunc);
+  if (!f) {
+    INTELLI_WARNING("Cannot write " << path);
+    return false;
+  }
+
+  auto csv = path.ends_with(".csv");
+  if (csv) {
+    f << "strategy,t,p,l,beta,x_rows,y_rows,cols,median_ms,p95_ms,min_ms,"
+         "error,energy_j\n";
+  } else {
+    f << "[\n";
+  }
+
+  for (size_t i = 0; i < rows.size(); ++i) {
+    const auto &row = rows[i];
+    if (csv) {
+      f << row.strategy << ',' << row.t << ',' << row.p << ',' << row.l << ','
+        << row.beta << ',' << row.xRows << ',' << row.yRows << ',' << row.cols
+        << ',' << row.medianMs << ',' << row.p95Ms << ',' << row.minMs << ','
+        << row.error << ',';
+      if (row.energyJ.has_value()) {
+        f << row.energyJ.value();
+      }
+      f << '\n';
+    } else {
+      f << "  {\"strategy\": \"" << row.strategy << "\", \"t\": " << row.t
+        << ", \"p\": " << row.p << ", \"l\": " << row.l
+        << ", \"beta\": " << row.beta << ", \"x_rows\": " << row.xRows
+        << ", \"y_rows\": " << row.yRows << ", \"cols\": " << row.cols
+        << ", \"median_ms\": " << row.medianMs
+        << ", \"p95_ms\": " << row.p95Ms << ", \"min_ms\": " << row.minMs
+        << ", \"error\": " << row.error << ", \"energy_j\": ";
+      if (row.energyJ.has_value()) {
+        f << row.energyJ.value();
+      } else {
+        f << "null";
+      }
+      f << (i + 1 < rows.size() ? "},\n" : "}\n");
+    }
+  }
+
+  if (!csv) {
+    f << "]\n";
+  }
+
+  return bool(f);
+}
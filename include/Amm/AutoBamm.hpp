@@ -0,0 +1,106 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_AMM_AUTOBAMM_HPP_
+#define IntelliStream_SRC_AMM_AUTOBAMM_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <Eigen/Dense>
+
+#include "Amm/Bamm.hpp"
+#include "Amm/ColumnPartitioner.hpp"
+#include "BS_thread_pool.hpp"
+#include "Svd/SequentialJTS.hpp"
+
+namespace GAMM {
+
+// Picks one of Single, IntraParallel, InterParallel and CombinedParallel (and
+// the value of p for the latter) from the shape of the input, using a cost
+// model calibrated on the current machine.
+//
+// The calibration runs a few reduction steps for the requested l and beta and
+// stores the per-step costs in a small TOML database, so later processes with
+// the same parameters skip the measurement.
+class AutoBamm : public Bamm {
+public:
+  enum class Strategy { Single, Intra, Inter, Combined };
+
+  struct Choice {
+    Strategy strategy;
+    size_t p;
+    double predictedMs;
+  };
+
+  struct Calibration {
+    // Cost of the QR, product and sketch update of one step, per row of bx or
+    // by
+    double rowNs;
+    // Cost of one SVD with SequentialJTS
+    double svdMs;
+    // Cost of one SVD with ParallelJTS for each of threads
+    std::vector<size_t> threads;
+    std::vector<double> svdParallelMs;
+    // Average number of input columns absorbed by a reduction step
+    double columnsPerStep;
+
+    double parallelSvdMs(size_t nthreads) const noexcept;
+  };
+
+  AutoBamm(size_t l, scalar_t beta, size_t t, size_t fanIn = 2,
+           std::optional<std::string> calibrationPath = {})
+      : AutoBamm(l, beta,
+                 t > 1 ? std::make_shared<BS::thread_pool>(t - 1) : nullptr, t,
+                 fanIn, ColumnPartitioner::Mode::Balanced,
+                 std::move(calibrationPath)) {}
+
+  // The chosen strategy and the calibration run on t threads, the caller and
+  // t - 1 of pool (which is not used when t is 1), so that no thread is
+  // created while sketching and the threads keep the caller's placement
+  AutoBamm(size_t l, scalar_t beta, BS::thread_pool_ptr pool, size_t t,
+           size_t fanIn = 2,
+           ColumnPartitioner::Mode partitioning =
+               ColumnPartitioner::Mode::Balanced,
+           std::optional<std::string> calibrationPath = {})
+      : Bamm(l, beta, std::make_unique<SequentialJTS>()), pool{std::move(pool)},
+        t{t}, fanIn{fanIn}, partitioning{partitioning},
+        calibrationPath{calibrationPath.has_value()
+                            ? std::move(calibrationPath.value())
+                            : defaultCalibrationPath()} {}
+
+  Choice choose(size_t mx, size_t my, size_t d);
+  const std::optional<Choice> &getChoice() const noexcept { return choice; }
+
+  // Loads the calibration for l and beta, measuring and saving it if the
+  // database has no usable entry
+  const Calibration &calibrate();
+
+  static std::string defaultCalibrationPath();
+
+protected:
+  void reduce() override;
+
+private:
+  Calibration measure() const;
+  std::optional<Calibration> load() const;
+  void save(const Calibration &calibration) const;
+  std::string databaseKey() const;
+
+  double predict(const Calibration &calibration, Strategy strategy, size_t p,
+                 size_t mx, size_t my, size_t d) const;
+
+  BS::thread_pool_ptr pool;
+  size_t t, fanIn;
+  ColumnPartitioner::Mode partitioning;
+  std::string calibrationPath;
+  std::optional<Calibration> calibration;
+  std::optional<Choice> choice;
+};
+
+std::ostream &operator<<(std::ostream &o, AutoBamm::Choice const &choice);
+} // namespace GAMM
+#endif
@@ -6,11 +6,14 @@
 #include <cstddef>
 #include <memory>
 #include <optional>
+#include <vector>
 
 #include <Eigen/Dense>
 
 #include "Svd/Svd.hpp"
+#include "Utils/LoadProfile.hpp"
 #include "Utils/Logger.hpp"
+#include "Utils/PhaseProfile.hpp"
 #include "Utils/ZeroedColumns.hpp"
 
 namespace GAMM {
@@ -20,7 +23,10 @@ public:
   struct result;
 
   Bamm(size_t l, scalar_t beta, SvdUPtr svd)
-      : l{l}, beta{beta}, svd{std::move(svd)} {
+      : l{l}, beta{beta}, svd{std::move(svd)},
+        profile{std::make_shared<PhaseProfile>()},
+        loadProfile{std::make_shared<LoadProfile>()} {
+    this->svd->setProfile(profile.get());
     attenuateVec.resize(l);
     for (size_t i = 0; i < l; ++i) {
       attenuateVec[i] = std::expm1((scalar_t)i * beta / ((scalar_t)l - 1.0)) /
@@ -28,50 +34,122 @@ public:
     }
   }
 
-  MatrixPtr multiply(Matrix &x, Matrix &y) {
-    bx = std::make_shared<Matrix>(x.rows(), l);
-    by = std::make_shared<Matrix>(y.rows(), l);
+  // Strategies own their thread pools, which must be released with them
+  virtual ~Bamm() = default;
 
-    auto d = x.cols();
-    this->x = x.leftCols(d);
-    this->y = y.leftCols(d);
+  MatrixPtr multiply(MatrixRef x, MatrixRef y) {
+    auto [bx, by] = sketch(std::move(x), std::move(y));
+    *bx *= by->transpose();
+    return bx;
+  }
+
+  // x and y must be compressed. Only their stored entries are copied into the
+  // sketch, and a column with no stored entries in x is skipped without being
+  // read, so explicit zeros should be pruned beforehand
+  MatrixPtr multiply(const SparseMatrix &x, const SparseMatrix &y) {
+    auto [bx, by] = sketch(x, y);
+    *bx *= by->transpose();
+    return bx;
+  }
+
+  // The sketches bx and by of x and y, for when the product bx * by^T is too
+  // large to be formed in memory
+  result sketch(MatrixRef x, MatrixRef y) {
+    // The sketches start out zeroed so that columns which are never filled
+    // (e.g. when d < l) do not contribute to the product
+    bx = std::make_shared<Matrix>(Matrix::Zero(x.rows(), l));
+    by = std::make_shared<Matrix>(Matrix::Zero(y.rows(), l));
+
+    // emplace rebinds the references, x and y are never copied
+    setInputs(std::move(x), std::move(y));
 
     zeroedColumns.resizeEmpty(l);
     xi = 0;
 
     reduce();
 
-    *bx.value() *= by.value()->transpose();
+    return {bx.value(), by.value()};
+  }
+
+  result sketch(const SparseMatrix &x, const SparseMatrix &y) {
+    bx = std::make_shared<Matrix>(Matrix::Zero(x.rows(), l));
+    by = std::make_shared<Matrix>(Matrix::Zero(y.rows(), l));
+
+    setInputs(UtilityFunctions::sparseRef(x), UtilityFunctions::sparseRef(y));
+
+    zeroedColumns.resizeEmpty(l);
+    xi = 0;
+
+    reduce();
 
-    return std::move(*bx);
+    return {bx.value(), by.value()};
   }
 
   void reduce(MatrixRef x, MatrixRef y, MatrixPtr bx, MatrixPtr by) {
+    setMatrices(std::move(x), std::move(y), std::move(bx), std::move(by));
+    reduce();
+  }
+
+  void reduce(SparseRef x, SparseRef y, MatrixPtr bx, MatrixPtr by) {
+    setMatrices(std::move(x), std::move(y), std::move(bx), std::move(by));
+    reduce();
+  }
+
+  void setMatrices(MatrixRef x, MatrixRef y, MatrixPtr bx, MatrixPtr by) {
     this->bx = std::move(bx);
     this->by = std::move(by);
-    this->x = std::move(x);
-    this->y = std::move(y);
+    setInputs(std::move(x), std::move(y));
 
     zeroedColumns.fromMatrix(*this->bx.value());
     xi = 0;
-
-    reduce();
   }
 
-  void setMatrices(MatrixRef x, MatrixRef y, MatrixPtr bx, MatrixPtr by) {
+  void setMatrices(SparseRef x, SparseRef y, MatrixPtr bx, MatrixPtr by) {
     this->bx = std::move(bx);
     this->by = std::move(by);
-    this->x = std::move(x);
-    this->y = std::move(y);
+    setInputs(std::move(x), std::move(y));
 
     zeroedColumns.fromMatrix(*this->bx.value());
     xi = 0;
   }
 
+  // Merges the sketches xs, ys (each of l columns) into bx, by with a single
+  // reduction: one QR of all (xs.size() + 1) * l columns, one SVD of their
+  // product and a truncation back to l columns. Absorbing them with reduce()
+  // instead would take one l-wide round per l columns
+  void merge(const std::vector<MatrixPtr> &xs, const std::vector<MatrixPtr> &ys,
+             MatrixPtr bx, MatrixPtr by);
+
   struct result {
     MatrixPtr bx, by;
   };
 
+  size_t getL() const noexcept { return l; }
+  scalar_t getBeta() const noexcept { return beta; }
+
+  // Number of columns of x taken so far by the current reduction
+  size_t columnsConsumed() const noexcept { return xi; }
+
+  // Time spent in each phase of the reductions so far
+  const PhaseProfile &getProfile() const noexcept { return *profile; }
+  PhaseProfilePtr getProfilePtr() const noexcept { return profile; }
+  // Records into profile instead, e.g. that of the Bamm this one works for
+  void setProfile(PhaseProfilePtr profile) noexcept {
+    this->profile = std::move(profile);
+    svd->setProfile(this->profile.get());
+  }
+
+  // CPU time spent on the reductions by threads other than the caller, e.g.
+  // those of a parallel SVD
+  uint64_t helperCpuNs() const noexcept { return svd->helperCpuNs(); }
+
+  // How the work was spread over the workers of the inter-parallel
+  // strategies. Left empty by the others
+  const LoadProfile &getLoadProfile() const noexcept { return *loadProfile; }
+  void setLoadProfile(LoadProfilePtr loadProfile) noexcept {
+    this->loadProfile = std::move(loadProfile);
+  }
+
     bool reductionStepSetup();
 
     bool reductionStepFinish();
@@ -83,15 +161,49 @@ protected:
 
   void parameterizedReduceRank(DiagonalMatrix &sv) const;
 
+  bool isSparse() const noexcept { return sx.has_value(); }
+  size_t xRows() const noexcept {
+    return isSparse() ? sx->rows() : x.value().rows();
+  }
+  size_t yRows() const noexcept {
+    return isSparse() ? sy->rows() : y.value().rows();
+  }
+  size_t inputCols() const noexcept {
+    return isSparse() ? sx->cols() : x.value().cols();
+  }
+
+  // Reduces n columns of the inputs from start into bx and by with bamm,
+  // whether the inputs are dense or sparse
+  void reduceInputCols(Bamm &bamm, size_t start, size_t n, MatrixPtr bx,
+                       MatrixPtr by) const;
+
   size_t l;
   scalar_t beta;
   size_t xi;
+  // Only one of x, y and sx, sy is set, depending on the inputs
   std::optional<MatrixRef> x, y;
+  std::optional<SparseRef> sx, sy;
   std::optional<MatrixPtr> bx, by;
   SvdUPtr svd;
   ZeroedColumns zeroedColumns;
+  PhaseProfilePtr profile;
+  LoadProfilePtr loadProfile;
 
 private:
+  void setInputs(MatrixRef x, MatrixRef y) {
+    this->x.emplace(std::move(x));
+    this->y.emplace(std::move(y));
+    sx.reset();
+    sy.reset();
+  }
+
+  void setInputs(SparseRef x, SparseRef y) {
+    sx.emplace(std::move(x));
+    sy.emplace(std::move(y));
+    this->x.reset();
+    this->y.reset();
+  }
+
   Vector attenuateVec;
 };
 
@@ -0,0 +1,95 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_AMM_CHECKPOINT_HPP_
+#define IntelliStream_SRC_AMM_CHECKPOINT_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "Utils/UtilityFunctions.hpp"
+
+namespace GAMM {
+
+// Header of a checkpoint file. All integers are little endian. It is followed
+// by bx and then by, as float32 columns, and checksum covers both. xHash and
+// yHash identify the columns of the inputs that were reduced into them.
+struct CheckpointHeader {
+  static constexpr char MAGIC[8] = {'G', 'A', 'M', 'M', 'C', 'K', 'P', 'T'};
+  static constexpr uint32_t VERSION = 2;
+
+  char magic[8];
+  uint32_t version;
+  uint32_t reserved;
+  uint64_t l, xRows, yRows, cols;
+  uint64_t nextCol;
+  uint64_t checksum;
+  double beta;
+  uint64_t xHash, yHash;
+  uint64_t reserved2;
+};
+
+static_assert(sizeof(CheckpointHeader) == 96,
+              "The sketches start on an aligned offset");
+
+// The state of a streaming reduction between two blocks: the sketches and the
+// first column of x and y that has not been reduced into them. The free
+// columns of the sketches are found again from bx when the reduction resumes.
+// xHash and yHash identify the inputs and are only compared by the callers:
+// SketchCache stores SketchCache::hash of x and y, OutOfCore the
+// SketchCache::hashColumns of their columns before nextCol.
+struct Checkpoint {
+  Matrix bx, by;
+  size_t cols, nextCol;
+  scalar_t beta;
+  uint64_t xHash, yHash;
+
+  // Whether the checkpoint was taken while reducing inputs of this shape
+  // with sketches of l columns and this beta
+  bool matches(size_t xRows, size_t yRows, size_t cols, size_t l,
+               scalar_t beta) const noexcept;
+
+  // Writes the checkpoint to a temporary file which then replaces path, so a
+  // crash while writing keeps the previous checkpoint. Returns false and logs
+  // a warning if it could not be written
+  bool save(const std::string &path) const;
+
+  // Returns nothing if there is no file at path, and logs a warning as well if
+  // it is not a valid checkpoint
+  static std::optional<Checkpoint> load(const std::string &path);
+};
+
+// Saves checkpoints on a background thread so that the reduction does not
+// wait for the disk. If a checkpoint is still being written when the next one
+// is submitted, the pending one is replaced, so at most two snapshots are held
+// in memory.
+class CheckpointWriter {
+public:
+  explicit CheckpointWriter(std::string path);
+  // Waits for the pending checkpoint to be written
+  ~CheckpointWriter();
+
+  CheckpointWriter(const CheckpointWriter &) = delete;
+  CheckpointWriter &operator=(const CheckpointWriter &) = delete;
+
+  void submit(Checkpoint checkpoint);
+  size_t written() const;
+
+private:
+  void writerTask();
+
+  std::string path;
+  std::optional<Checkpoint> pending;
+  bool stop{false};
+  size_t nwritten{0};
+
+  mutable std::mutex mtx;
+  std::condition_variable submitted;
+  std::thread writer;
+};
+} // namespace GAMM
+#endif
@@ -0,0 +1,49 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_AMM_COLUMNPARTITIONER_HPP_
+#define IntelliStream_SRC_AMM_COLUMNPARTITIONER_HPP_
+
+#include <cstddef>
+#include <ostream>
+#include <vector>
+
+#include "BS_thread_pool.hpp"
+#include "Utils/UtilityFunctions.hpp"
+
+namespace GAMM {
+
+// Splits the columns of x into the leaf partitions of the inter-parallel
+// strategies.
+//
+// reductionStepSetup skips the zero columns of x, so the work of a leaf is its
+// number of non-zero columns rather than its width. These are counted up front
+// and, in Balanced mode, the partitions are chosen so that each one gets the
+// same number of non-zero columns. On dense inputs both modes give the same
+// partitions as unevenDivide.
+class ColumnPartitioner {
+public:
+  enum class Mode { Even, Balanced };
+
+  // The non-zero columns are counted using pool and the calling thread
+  ColumnPartitioner(const MatrixRef &x, size_t parts, Mode mode,
+                    BS::thread_pool &pool);
+  // The non-empty columns of a sparse x are found from its column pointers
+  ColumnPartitioner(const SparseRef &x, size_t parts, Mode mode);
+
+  size_t size() const noexcept { return loads.size(); }
+  UtilityFunctions::divideResult get(size_t i) const noexcept {
+    return {bounds[i], bounds[i + 1] - bounds[i]};
+  }
+  // Number of non-zero columns in partition i
+  size_t load(size_t i) const noexcept { return loads[i]; }
+
+private:
+  // nonZero[j] is the number of non-zero columns before column j
+  void partition(const std::vector<size_t> &nonZero, size_t parts, Mode mode);
+
+  std::vector<size_t> bounds, loads;
+};
+
+std::ostream &operator<<(std::ostream &o, ColumnPartitioner const &partitioner);
+} // namespace GAMM
+#endif
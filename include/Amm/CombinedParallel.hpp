@@ -11,6 +11,9 @@
 #include <Eigen/Dense>
 
 #include "Amm/Bamm.hpp"
+#include "Amm/ColumnPartitioner.hpp"
+#include "Amm/MergeTree.hpp"
+#include "Amm/SketchMerge.hpp"
 #include "BS_thread_pool.hpp"
 #include "Svd/SequentialJTS.hpp"
 #include "Utils/ZeroedColumns.hpp"
@@ -18,37 +21,52 @@
 namespace GAMM {
 
 class CombinedParallel : public Bamm {
-  struct LockedMatrices {
-    std::mutex mtx;
-    MatrixPtr bx, by;
-  };
-
-  size_t p;
+  size_t t, p;
   BS::thread_pool_ptr pool;
-  std::vector<LockedMatrices> matrices;
-  std::barrier<> barrier;
+  std::vector<LockedSketch> matrices;
+  // Sized to the number of partitions actually used by reduce()
+  std::optional<std::barrier<>> barrier;
+  MergeTree tree;
+  ColumnPartitioner::Mode partitioning;
+  std::optional<ColumnPartitioner> partitions;
 
   // The way CombinedParallel works is that at each level of inter-parallelism,
-  // each thread gets equal number of threads to use for intra-parallelism. This
-  // works fine with t threads if all the inter-parallel workers are in the same
-  // level at the same time. Due to inconsistent execution time however, some
-  // worker may proceed to the next level and consume all available threads
-  // before a previous level is finished for another worker. By giving p extra
-  // threads, there are more than enough threads to execute on.
-  size_t getT() const { return pool->get_thread_count() - p + 1; }
+  // each worker gets the threads of the leaves below it in the merge tree to
+  // use for intra-parallelism. A worker only moves up a level once its
+  // children are done, so the teams never ask for more than t threads in total
+  // even when the workers are at different levels, and a pool of t - 1 threads
+  // (the caller being the last one) is enough.
+  size_t getT() const { return t; }
   void workerTask(size_t workerId);
 
-  size_t getNumIntraThreads(size_t workerId, int i);
+  size_t getNumIntraThreads(size_t workerId, size_t level);
 
 public:
-  // See getT() for the reason for t+p-1 threads being spawned
-  CombinedParallel(size_t l, scalar_t beta, size_t t, size_t p)
+  // t+p-1 threads are spawned, leaving p more than needed (see getT()) as
+  // slack. fanIn is the number of sketches combined by each merge of the
+  // reduction tree and partitioning selects how the columns are split between
+  // the leaves
+  CombinedParallel(size_t l, scalar_t beta, size_t t, size_t p,
+                   size_t fanIn = 2,
+                   ColumnPartitioner::Mode partitioning =
+                       ColumnPartitioner::Mode::Balanced)
       : CombinedParallel(l, beta, std::make_shared<BS::thread_pool>(t + p - 1),
-                         p) {}
+                         p, fanIn, partitioning) {}
+
+  CombinedParallel(size_t l, scalar_t beta, BS::thread_pool_ptr pool, size_t p,
+                   size_t fanIn = 2,
+                   ColumnPartitioner::Mode partitioning =
+                       ColumnPartitioner::Mode::Balanced)
+      : CombinedParallel(l, beta, pool, pool->get_thread_count() - p + 1, p,
+                         fanIn, partitioning) {}
 
-  CombinedParallel(size_t l, scalar_t beta, BS::thread_pool_ptr pool, size_t p)
-      : Bamm(l, beta, std::make_unique<SequentialJTS>()), p{p}, pool{pool},
-        barrier(p) {}
+  // Runs on t threads, the caller and t - 1 of pool, which may be shared with
+  // the Bamm this one works for
+  CombinedParallel(size_t l, scalar_t beta, BS::thread_pool_ptr pool, size_t t,
+                   size_t p, size_t fanIn,
+                   ColumnPartitioner::Mode partitioning)
+      : Bamm(l, beta, std::make_unique<SequentialJTS>()), t{t}, p{p},
+        pool{pool}, tree{p, fanIn}, partitioning{partitioning} {}
 
   void reduce() override;
 };
@@ -11,6 +11,9 @@
 #include <Eigen/Dense>
 
 #include "Amm/Bamm.hpp"
+#include "Amm/ColumnPartitioner.hpp"
+#include "Amm/MergeTree.hpp"
+#include "Amm/SketchMerge.hpp"
 #include "BS_thread_pool.hpp"
 #include "Svd/SequentialJTS.hpp"
 #include "Utils/ZeroedColumns.hpp"
@@ -18,25 +21,33 @@
 namespace GAMM {
 
 class InterParallel : public Bamm {
-  struct LockedMatrices {
-    std::mutex mtx;
-    MatrixPtr bx, by;
-  };
-
   BS::thread_pool_ptr pool;
-  std::vector<LockedMatrices> matrices;
+  std::vector<LockedSketch> matrices;
   std::barrier<> barrier;
+  MergeTree tree;
+  ColumnPartitioner::Mode partitioning;
+  std::optional<ColumnPartitioner> partitions;
 
   size_t getT() const { return pool->get_thread_count() + 1; }
   void workerTask(size_t workerId);
 
 public:
-  InterParallel(size_t l, scalar_t beta, size_t t)
-      : InterParallel(l, beta, std::make_shared<BS::thread_pool>(t - 1)) {}
-
-  InterParallel(size_t l, scalar_t beta, BS::thread_pool_ptr pool)
+  // fanIn is the number of sketches combined by each merge of the reduction
+  // tree (the merging worker's own sketch plus fanIn - 1 children).
+  // partitioning selects how the columns are split between the leaves
+  InterParallel(size_t l, scalar_t beta, size_t t, size_t fanIn = 2,
+                ColumnPartitioner::Mode partitioning =
+                    ColumnPartitioner::Mode::Balanced)
+      : InterParallel(l, beta, std::make_shared<BS::thread_pool>(t - 1), fanIn,
+                      partitioning) {}
+
+  InterParallel(size_t l, scalar_t beta, BS::thread_pool_ptr pool,
+                size_t fanIn = 2,
+                ColumnPartitioner::Mode partitioning =
+                    ColumnPartitioner::Mode::Balanced)
       : Bamm(l, beta, std::make_unique<SequentialJTS>()), pool{pool},
-        barrier{pool->get_thread_count() + 1} {}
+        barrier{pool->get_thread_count() + 1},
+        tree{pool->get_thread_count() + 1, fanIn}, partitioning{partitioning} {}
   void reduce() override;
 };
 } // namespace GAMM
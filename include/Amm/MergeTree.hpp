@@ -0,0 +1,48 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_AMM_MERGETREE_HPP_
+#define IntelliStream_SRC_AMM_MERGETREE_HPP_
+
+#include <cstddef>
+#include <vector>
+
+namespace GAMM {
+
+// Shape of the reduction tree used by the inter-parallel strategies. Worker
+// ids are laid out so that at level i (i >= 1) every worker whose id is a
+// multiple of fanIn^i absorbs the sketches of up to fanIn - 1 children spaced
+// fanIn^(i-1) apart. Level 0 is the leaf reduction over a column partition.
+//
+// With fanIn = 2 this is the binary tree that was previously hard-wired via
+// trailingZeros(workerId | nextPowerOfTwo(t)).
+class MergeTree {
+public:
+  MergeTree() : MergeTree(1, 2) {}
+  MergeTree(size_t t, size_t fanIn);
+
+  size_t getT() const noexcept { return t; }
+  size_t getFanIn() const noexcept { return fanIn; }
+
+  // Number of levels (including the leaf) that workerId takes part in
+  size_t nlevels(size_t workerId) const noexcept;
+  // Total number of levels in the tree, including the leaf level
+  size_t depth() const noexcept { return nlevels(0); }
+
+  // Ids of the workers whose sketches workerId absorbs at the given level
+  std::vector<size_t> children(size_t workerId, size_t level) const;
+
+  // Number of workers doing work at the given level
+  size_t nactive(size_t level) const noexcept;
+  // Position of workerId amongst the active workers of the given level
+  size_t rank(size_t workerId, size_t level) const noexcept;
+  // Last leaf of the subtree workerId has absorbed by the end of the given
+  // level
+  size_t lastLeaf(size_t workerId, size_t level) const noexcept;
+
+private:
+  size_t stride(size_t level) const noexcept;
+
+  size_t t, fanIn;
+};
+} // namespace GAMM
+#endif
@@ -0,0 +1,59 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_AMM_OUTOFCORE_HPP_
+#define IntelliStream_SRC_AMM_OUTOFCORE_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <optional>
+#include <string>
+
+#include <Eigen/Dense>
+
+#include "Amm/Bamm.hpp"
+#include "Utils/ColumnBlockReader.hpp"
+
+namespace GAMM {
+
+// Sketches matrices that do not fit in memory. X and Y are read blockCols
+// columns at a time and each pair of blocks is reduced into the sketch by
+// bamm, so memory use is bounded by the sketch plus prefetchDepth pairs of
+// blocks. The blocks are read by a BlockPrefetcher, so reads overlap with the
+// reduction. Any strategy can be used for the reduction of a block.
+//
+// With a checkpoint path, the sketch is saved there (see Checkpoint) at most
+// once per checkpointInterval, and a later sketch of the same inputs with the
+// same l and beta resumes from it. The columns reduced so far are hashed into
+// the checkpoint and read again to check them before resuming. The file is
+// removed once the sketch is complete.
+class OutOfCore {
+public:
+  OutOfCore(Bamm &bamm, size_t blockCols, size_t prefetchDepth = 2,
+            std::optional<std::string> checkpointPath = {},
+            std::chrono::seconds checkpointInterval = std::chrono::seconds{60})
+      : bamm{bamm}, blockCols{blockCols}, prefetchDepth{prefetchDepth},
+        checkpointPath{std::move(checkpointPath)},
+        checkpointInterval{checkpointInterval} {}
+
+  // Returns nothing and logs a warning if the files do not match or cannot be
+  // read
+  std::optional<Bamm::result> sketch(ColumnBlockReader &x,
+                                     ColumnBlockReader &y);
+  // bx * by^T of the sketch
+  std::optional<MatrixPtr> multiply(ColumnBlockReader &x,
+                                    ColumnBlockReader &y);
+
+  // The exact x * y^T, accumulated one block at a time
+  static std::optional<Matrix> exactProduct(ColumnBlockReader &x,
+                                            ColumnBlockReader &y,
+                                            size_t blockCols,
+                                            size_t prefetchDepth = 2);
+
+private:
+  Bamm &bamm;
+  size_t blockCols, prefetchDepth;
+  std::optional<std::string> checkpointPath;
+  std::chrono::seconds checkpointInterval;
+};
+} // namespace GAMM
+#endif
@@ -0,0 +1,63 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_AMM_SKETCHCACHE_HPP_
+#define IntelliStream_SRC_AMM_SKETCHCACHE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "Amm/Bamm.hpp"
+#include "Amm/ColumnPartitioner.hpp"
+#include "BS_thread_pool.hpp"
+#include "Utils/UtilityFunctions.hpp"
+
+namespace GAMM {
+
+// On-disk cache of the sketches of one pair of inputs.
+//
+// Entries are keyed by a hash of the contents of x and y together with every
+// setting the sketch depends on (see Key), and are stored as complete
+// checkpoints (see Checkpoint) in directory. The inputs are hashed once, when
+// the cache is created, in chunks spread over pool and the calling thread.
+class SketchCache {
+public:
+  // The settings a sketch was made with. t is the number of threads, p the
+  // number of partitions of the combined strategy, and fanIn and partitioning
+  // shape the merge tree of the inter-parallel ones
+  struct Key {
+    size_t l;
+    scalar_t beta;
+    std::string_view strategy;
+    size_t t, p, fanIn;
+    ColumnPartitioner::Mode partitioning;
+  };
+
+  SketchCache(std::string directory, MatrixRef x, MatrixRef y,
+              BS::thread_pool *pool = nullptr);
+
+  // Returns nothing on a miss
+  std::optional<Bamm::result> get(const Key &key) const;
+  // Returns false and logs a warning if the entry could not be saved
+  bool put(const Key &key, const Bamm::result &sketch) const;
+
+  std::string path(const Key &key) const;
+
+  // Hash of the shape and entries of m. Columns are hashed in fixed-size
+  // chunks, so the result does not depend on the number of threads
+  static uint64_t hash(MatrixRef m, BS::thread_pool *pool = nullptr);
+  // Running hash of the columns of m, continuing from h. Hashing a matrix a
+  // block of columns at a time gives the same result however it is split
+  static uint64_t hashColumns(MatrixRef m, uint64_t h);
+  // Start value of hashColumns
+  static uint64_t emptyHash();
+
+private:
+  std::string directory;
+  uint64_t xHash, yHash;
+  size_t xRows, yRows, cols;
+};
+} // namespace GAMM
+#endif
@@ -0,0 +1,35 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_AMM_SKETCHMERGE_HPP_
+#define IntelliStream_SRC_AMM_SKETCHMERGE_HPP_
+
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include "Amm/Bamm.hpp"
+#include "Amm/MergeTree.hpp"
+
+namespace GAMM {
+
+// The sketch of a worker of the inter-parallel strategies. The worker holds
+// the lock until it is done with the sketch, so that its parent only merges
+// it once it is final
+struct LockedSketch {
+  std::mutex mtx;
+  MatrixPtr bx, by;
+};
+
+// Waits for the children of workerId at the given level of tree to be done
+// with their sketches, whose locks are held until the guards are released
+std::vector<std::unique_lock<std::mutex>>
+lockChildren(const MergeTree &tree, std::vector<LockedSketch> &sketches,
+             size_t workerId, size_t level);
+
+// Merges the sketches of workerId's children at the given level of tree into
+// its own with bamm, in a single reduction. Their locks must be held
+void mergeChildren(Bamm &bamm, const MergeTree &tree,
+                   std::vector<LockedSketch> &sketches, size_t workerId,
+                   size_t level);
+} // namespace GAMM
+#endif
@@ -29,7 +29,12 @@ public:
   virtual bool svdStep() override;
   virtual bool svdStep(size_t nsteps) override;
 
-private:
+  virtual uint64_t helperCpuNs() const noexcept override {
+    return helperCpu.load(std::memory_order_relaxed);
+  }
+
+protected:
+  // The phases are protected so that they can be timed on their own
   static constexpr size_t COMPLETED = std::numeric_limits<size_t>::max();
 
   auto &getP() noexcept { return pToUse ? p2 : p1; }
@@ -50,6 +55,8 @@ private:
 
   std::barrier<> barrier;
   std::atomic_size_t counter;
+  // CPU time of the workers run on the pool
+  std::atomic_uint64_t helperCpu{0};
   // (lock, data guarded)
   //
   // The data guarded is the length of the slice which has been sorted by the
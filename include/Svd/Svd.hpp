@@ -3,16 +3,20 @@
 #ifndef IntelliStream_SRC_SVD_SVD_HPP_
 #define IntelliStream_SRC_SVD_SVD_HPP_
 
+#include "Utils/PhaseProfile.hpp"
 #include "Utils/UtilityFunctions.hpp"
 #include <Eigen/Dense>
 #include <Eigen/src/Core/Diagonal.h>
 #include <Eigen/src/Core/DiagonalMatrix.h>
 #include <Eigen/src/Core/util/Constants.h>
+#include <cstdint>
 #include <memory>
 
 namespace GAMM {
 class Svd {
 public:
+  virtual ~Svd() = default;
+
   const Matrix &matrixU() const noexcept { return u; }
   const Matrix &matrixV() const noexcept { return v; }
   const DiagonalMatrix &singularValues() const noexcept { return sv; }
@@ -34,12 +38,19 @@ public:
   }
   virtual void finishSvd() = 0;
 
+  // CPU time the threads other than the caller spent on the SVDs so far
+  virtual uint64_t helperCpuNs() const noexcept { return 0; }
+
+  // The phases of each sweep are recorded into profile, if set
+  void setProfile(PhaseProfile *profile) noexcept { this->profile = profile; }
+
 protected:
   void sortSingularValues() noexcept;
 
   Matrix u;
   Matrix v;
   DiagonalMatrix sv;
+  PhaseProfile *profile{nullptr};
 };
 
 typedef std::unique_ptr<Svd> SvdUPtr;
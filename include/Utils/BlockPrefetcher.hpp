@@ -0,0 +1,74 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_UTILS_BLOCKPREFETCHER_HPP_
+#define IntelliStream_SRC_UTILS_BLOCKPREFETCHER_HPP_
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#include "Utils/ColumnBlockReader.hpp"
+#include "Utils/UtilityFunctions.hpp"
+
+namespace GAMM {
+
+// Reads the column blocks of X and Y on a dedicated thread, ahead of the
+// consumer. depth buffers are cycled between the reader and the consumer, so
+// with the default of 2 the next block is read while the current one is being
+// reduced, and the reader blocks once it is depth blocks ahead.
+class BlockPrefetcher {
+public:
+  struct Block {
+    Matrix x, y;
+    size_t start, cols;
+  };
+
+  struct Stats {
+    size_t blocks{0}, bytes{0};
+    // Time the reader spent in reads, and the consumer spent waiting for them
+    double readMs{0.0}, waitMs{0.0};
+
+    double throughputMBs() const noexcept {
+      return readMs > 0.0 ? bytes / 1e3 / readMs : 0.0;
+    }
+  };
+
+  // Blocks are read from column startCol onwards
+  BlockPrefetcher(ColumnBlockReader &x, ColumnBlockReader &y, size_t blockCols,
+                  size_t depth = 2, size_t startCol = 0);
+  ~BlockPrefetcher();
+
+  BlockPrefetcher(const BlockPrefetcher &) = delete;
+  BlockPrefetcher &operator=(const BlockPrefetcher &) = delete;
+
+  // The next block in column order, or nullptr once all blocks have been
+  // returned or a read failed. The block stays valid until the next call
+  const Block *next();
+  bool failed() const;
+  Stats getStats() const;
+
+private:
+  void readerTask();
+
+  ColumnBlockReader &x, &y;
+  size_t blockCols, startCol;
+
+  std::vector<Block> slots;
+  std::deque<size_t> freeSlots, readySlots;
+  std::optional<size_t> current;
+  bool done{false}, stop{false}, error{false};
+  Stats stats;
+
+  mutable std::mutex mtx;
+  std::condition_variable slotFreed, blockReady;
+  std::thread reader;
+};
+
+std::ostream &operator<<(std::ostream &o, BlockPrefetcher::Stats const &stats);
+} // namespace GAMM
+#endif
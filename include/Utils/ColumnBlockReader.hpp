@@ -0,0 +1,56 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_UTILS_COLUMNBLOCKREADER_HPP_
+#define IntelliStream_SRC_UTILS_COLUMNBLOCKREADER_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "Utils/MatrixFile.hpp"
+#include "Utils/UtilityFunctions.hpp"
+
+namespace GAMM {
+
+// Reads a matrix file a block of columns at a time with pread, so that only
+// the block is ever held in memory. Column-major float32 files are read
+// straight into the block, other layouts and dtypes go through a buffer.
+class ColumnBlockReader {
+public:
+  static std::optional<std::unique_ptr<ColumnBlockReader>>
+  open(const std::string &path);
+
+  ~ColumnBlockReader();
+
+  ColumnBlockReader(const ColumnBlockReader &) = delete;
+  ColumnBlockReader &operator=(const ColumnBlockReader &) = delete;
+
+  size_t rows() const noexcept { return description.rows; }
+  size_t cols() const noexcept { return description.cols; }
+  const std::string &getPath() const noexcept { return path; }
+  // Total number of bytes read from the file so far
+  size_t bytesRead() const noexcept { return nbytes; }
+
+  // Reads the columns starting at start into the left columns of block, which
+  // must have rows() rows. Returns the number of columns read, which is less
+  // than block.cols() at the end of the matrix, or nothing on an I/O error
+  std::optional<size_t> read(size_t start, Matrix &block);
+
+private:
+  ColumnBlockReader(std::string path, int fd, MatrixFile::Description description)
+      : path{std::move(path)}, fd{fd}, description{description} {}
+
+  bool readFully(void *buf, size_t size, size_t offset);
+
+  std::string path;
+  int fd;
+  MatrixFile::Description description;
+  std::vector<char> buffer;
+  size_t nbytes{0};
+};
+
+typedef std::unique_ptr<ColumnBlockReader> ColumnBlockReaderUPtr;
+} // namespace GAMM
+#endif
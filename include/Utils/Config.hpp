@@ -9,11 +9,14 @@
 #include <optional>
 #include <ostream>
 #include <string_view>
+#include <vector>
 
 #define TOML_EXCEPTIONS 0
 
 #include "toml.hpp"
 
+#include "Utils/MappedMatrix.hpp"
+#include "Utils/SyntheticWorkload.hpp"
 #include "Utils/UtilityFunctions.hpp"
 
 namespace GAMM {
@@ -37,29 +40,86 @@ public:
   Config(int argc, const char *const *argv);
 
   struct Bins {
-    std::uint8_t single : 1, intra : 1, inter : 1, combined : 1, dynamic : 1;
+    std::uint8_t single : 1, intra : 1, inter : 1, combined : 1, dynamic : 1,
+        autotune : 1;
     bool isEmpty() {
       return (single == 0) && (intra == 0) && (inter == 0) && (combined == 0) &&
-             (dynamic == 0);
+             (dynamic == 0) && (autotune == 0);
     }
   };
 
-  static constexpr Bins RUN_NONE = {0, 0, 0, 0, 0};
-  static constexpr Bins RUN_ALL = {1, 1, 1, 1, 1};
+  static constexpr Bins RUN_NONE = {0, 0, 0, 0, 0, 0};
+  // Autotuning calibrates and writes the calibration file, so it only runs
+  // when asked for with -b auto
+  static constexpr Bins RUN_ALL = {1, 1, 1, 1, 1, 0};
 
   std::string x{"./benchmark/datasets/x.dat"}, y{"./benchmark/datasets/y.dat"};
+  // When set, x and y are generated in memory instead of being read from the
+  // files above
+  std::optional<SyntheticWorkload::Options> synthetic;
   size_t l{400}, t{std::thread::hardware_concurrency()};
+  // Number of sketches combined by each merge of the inter-parallel reduction
+  // tree
+  size_t fanIn{2};
+  // Split the columns between the inter-parallel leaves so that each gets the
+  // same number of non-zero columns, rather than the same number of columns
+  bool balancedPartitions{true};
   scalar_t beta{28.0};
+  // When non-zero, x and y are read from disk this many columns at a time
+  // instead of being loaded into memory
+  size_t blockCols{0};
+  // Number of blocks read ahead of the reduction when sketching out of core
+  size_t prefetchDepth{2};
+  // When set, the out of core sketch is saved to this file every
+  // checkpointInterval seconds and resumed from it
+  std::optional<std::string> checkpointPath;
+  size_t checkpointInterval{60};
+  // When set, the approximate product of each amm is written to this
+  // directory tileCols columns at a time
+  std::optional<std::string> outputPath;
+  size_t tileCols{1024};
+  // When set, the sketches of in memory inputs are looked up in and saved to
+  // this directory, keyed by the contents of x and y, the strategy and its
+  // settings
+  std::optional<std::string> sketchCache;
+  // Reduce sparse copies of x and y rather than the dense matrices
+  bool sparse{false};
   Bins bins{RUN_NONE};
+  // Count cycles, instructions, cache and branch misses of each amm
+  bool perfCounters{false};
+  // Print the time spent in each phase of the reductions of each amm
+  bool printPhases{false};
+  // When set, a timeline of the tasks and phases of every run is written to
+  // this file at exit, in the Chrome trace format
+  std::optional<std::string> tracePath;
   bool measureEnergy{false};
   std::optional<std::string> energyCSVPath;
-
+  // Calibration database used by AutoBamm, defaults to a per-user cache file
+  std::optional<std::string> calibrationPath;
+  // When set, pin the benchmark threads using this placement, either compact
+  // or scatter
+  std::optional<std::string> pinThreads;
+
+  // When set, the benchmark runs each strategy in bins for every combination
+  // of the sweep values, an empty list standing for the single value above,
+  // and writes one row per combination to this file as JSON, or as CSV if it
+  // ends in .csv
+  std::optional<std::string> sweepPath;
+  std::vector<size_t> sweepThreads, sweepP, sweepL, sweepCols, sweepRows;
+  std::vector<scalar_t> sweepBeta;
+  // Take sweepCols as a number of columns per thread, for weak scaling
+  bool sweepWeak{false};
+  // Untimed and timed runs of each combination
+  size_t warmups{1}, repetitions{5};
+
+  // Loads x and y concurrently, converting them with t threads, or generates
+  // them when synthetic is set
   std::optional<matrices> loadMatrices() const noexcept;
 
   struct matrices {
-    MatrixPtr x, y;
+    MappedMatrixPtr x, y;
 
-    matrices(MatrixPtr x, MatrixPtr y) : x{x}, y{y} {}
+    matrices(MappedMatrixPtr x, MappedMatrixPtr y) : x{x}, y{y} {}
   };
 
 private:
@@ -0,0 +1,74 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_UTILS_LOADPROFILE_HPP_
+#define IntelliStream_SRC_UTILS_LOADPROFILE_HPP_
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <ostream>
+#include <vector>
+
+namespace GAMM {
+
+// How the work of the inter-parallel strategies was spread over their
+// workers: the CPU time each spent at each level of the merge tree, the time
+// it waited for the other workers and the number of tasks it ran.
+//
+// Busy time is the CPU time of the thread running the worker, read with
+// CLOCK_THREAD_CPUTIME_ID, so time during which the thread was preempted does
+// not count. For CombinedParallel it includes the CPU time of the threads of
+// the worker's intra-parallel team, and the idle fraction is taken over all
+// the threads of the strategy.
+//
+// Each worker only writes its own slot, so recording takes no lock. begin and
+// end must be called from the thread that waits for all the workers.
+class LoadProfile {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Level {
+    uint64_t busyNs{0}, waitNs{0}, tasks{0}, threads{0};
+  };
+
+  // Starts a reduction over nworkers workers and nlevels levels, which runs on
+  // nthreads threads (one per worker if 0)
+  void begin(size_t nworkers, size_t nlevels, size_t nthreads = 0);
+  void end();
+
+  // Adds one task of worker at the given level
+  void record(size_t worker, size_t level, uint64_t busyNs, uint64_t waitNs,
+              size_t threads = 1) noexcept;
+  void reset() noexcept;
+
+  size_t nworkers() const noexcept { return workers.size(); }
+  size_t nlevels() const noexcept;
+  const Level &get(size_t worker, size_t level) const {
+    return workers[worker][level];
+  }
+  uint64_t busyNs(size_t worker) const noexcept;
+
+  // Busy time of the busiest worker over that of the mean worker
+  double imbalance() const noexcept;
+  // Fraction of the time of the workers, from begin to end, not spent busy
+  double idleFraction() const noexcept;
+
+  // CPU time of the calling thread
+  static uint64_t threadCpuNs() noexcept;
+
+private:
+  std::vector<std::vector<Level>> workers;
+  // Wall time of the reductions times their number of threads
+  uint64_t capacityNs{0};
+  size_t running{0};
+  Clock::time_point started;
+};
+
+typedef std::shared_ptr<LoadProfile> LoadProfilePtr;
+
+// The imbalance and idle fraction, then one line per level with its tasks and
+// the total, maximum and mean busy and wait times of its workers
+std::ostream &operator<<(std::ostream &o, LoadProfile const &load);
+} // namespace GAMM
+#endif
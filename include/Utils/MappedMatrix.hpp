@@ -0,0 +1,86 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_UTILS_MAPPEDMATRIX_HPP_
+#define IntelliStream_SRC_UTILS_MAPPEDMATRIX_HPP_
+
+#include <cstddef>
+#include <memory>
+#include <optional>
+#include <string>
+
+#include <Eigen/Dense>
+
+#include "BS_thread_pool.hpp"
+#include "Utils/UtilityFunctions.hpp"
+
+namespace GAMM {
+
+// A read-only matrix loaded from one of the benchmark's matrix files.
+//
+// .gmat files (see GmatHeader) holding float32 columns are mapped and used in
+// place without any copy, other dtypes and layouts are converted on load.
+//
+// The legacy formats start with the number of rows and columns as little
+// endian 64-bit integers followed by the float32 entries. In .dat files the
+// entries are stored row by row, so they are transposed into an owned Matrix.
+// In .cdat files they are stored column by column and are mapped.
+//
+// NumPy .npy files are mapped when they hold float32 entries in Fortran order
+// and converted otherwise. Matrix Market files are parsed into memory.
+//
+// Conversions are split into ranges of rows or columns, each copied from its
+// own part of the mapping, so that with a pool the pages are faulted in and
+// converted by several threads at once.
+class MappedMatrix {
+public:
+  typedef Eigen::Map<const Matrix> MapType;
+  typedef Eigen::Map<const Vector> NormsType;
+
+  // If verify is set, the checksum of .gmat files is checked, which reads the
+  // whole file. If pool is given, files that need converting are converted
+  // using pool and the calling thread
+  static std::optional<std::shared_ptr<const MappedMatrix>>
+  open(const std::string &path, bool verify = false,
+       BS::thread_pool *pool = nullptr);
+
+  explicit MappedMatrix(Matrix matrix, std::optional<Vector> norms = {});
+  ~MappedMatrix();
+
+  MappedMatrix(const MappedMatrix &) = delete;
+  MappedMatrix &operator=(const MappedMatrix &) = delete;
+
+  MapType map() const noexcept { return MapType(data, rows, cols); }
+  bool isMapped() const noexcept { return mapping != nullptr; }
+
+  // The per-column norms stored in the file, if any
+  std::optional<NormsType> columnNorms() const noexcept {
+    if (norms == nullptr) {
+      return {};
+    }
+    return NormsType(norms, cols);
+  }
+
+private:
+  MappedMatrix(void *mapping, size_t mappingLength, const scalar_t *data,
+               size_t rows, size_t cols, const scalar_t *norms = nullptr);
+
+  static std::optional<std::shared_ptr<const MappedMatrix>>
+  openGmat(const std::string &path, void *mapping, size_t length, bool verify,
+           BS::thread_pool *pool);
+  static std::optional<std::shared_ptr<const MappedMatrix>>
+  openNpy(const std::string &path, void *mapping, size_t length,
+          BS::thread_pool *pool);
+
+  void *mapping{nullptr};
+  size_t mappingLength{0};
+  std::optional<Matrix> owned;
+  std::optional<Vector> ownedNorms;
+
+  const scalar_t *data;
+  Eigen::Index rows, cols;
+  const scalar_t *norms{nullptr};
+};
+
+typedef std::shared_ptr<const MappedMatrix> MappedMatrixPtr;
+} // namespace GAMM
+#endif
@@ -0,0 +1,104 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_UTILS_MATRIXFILE_HPP_
+#define IntelliStream_SRC_UTILS_MATRIXFILE_HPP_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "BS_thread_pool.hpp"
+#include "Utils/UtilityFunctions.hpp"
+
+namespace GAMM {
+
+// Header of a .gmat matrix file. All integers are little endian.
+//
+// The payload starts at payloadOffset, a multiple of ALIGNMENT, and holds the
+// entries in the given dtype and layout. If hasColumnNorms is set, the
+// Euclidean norm of every column follows at normsOffset (also aligned) in the
+// same dtype. checksum covers the payload followed by the norms.
+struct GmatHeader {
+  static constexpr char MAGIC[8] = {'G', 'A', 'M', 'M', 'M', 'A', 'T', '\0'};
+  static constexpr uint32_t VERSION = 1;
+  static constexpr size_t ALIGNMENT = 64;
+
+  enum class DType : uint8_t { Float32 = 0, Float64 = 1 };
+  enum class Layout : uint8_t { ColumnMajor = 0, RowMajor = 1 };
+
+  char magic[8];
+  uint32_t version;
+  DType dtype;
+  Layout layout;
+  uint8_t hasColumnNorms;
+  uint8_t reserved;
+  uint64_t rows, cols;
+  uint64_t payloadOffset;
+  uint64_t normsOffset;
+  uint64_t checksum;
+  uint8_t padding[8];
+
+  size_t dtypeSize() const noexcept {
+    return dtype == DType::Float64 ? sizeof(double) : sizeof(float);
+  }
+};
+
+static_assert(sizeof(GmatHeader) == GmatHeader::ALIGNMENT,
+              "The payload of a .gmat file starts on the next aligned offset");
+
+class MatrixFile {
+public:
+  // Where and how the entries of a matrix file are stored, for any of the
+  // formats understood by MappedMatrix
+  struct Description {
+    size_t rows, cols;
+    size_t payloadOffset;
+    GmatHeader::DType dtype;
+    GmatHeader::Layout layout;
+
+    size_t dtypeSize() const noexcept {
+      return dtype == GmatHeader::DType::Float64 ? sizeof(double)
+                                                 : sizeof(float);
+    }
+  };
+
+  // Magic bytes of NumPy .npy files and Matrix Market files
+  static constexpr char NPY_MAGIC[6] = {'\x93', 'N', 'U', 'M', 'P', 'Y'};
+  static constexpr char MATRIX_MARKET_MAGIC[14] = {
+      '%', '%', 'M', 'a', 't', 'r', 'i', 'x', 'M', 'a', 'r', 'k', 'e', 't'};
+
+  // Reads the header of the file at path. Returns nothing and logs a warning
+  // if the file is not a valid matrix file. Matrix Market files are text and
+  // have no fixed layout, so they cannot be described
+  static std::optional<Description> describe(const std::string &path);
+
+  // Parses the header of a .npy file, which starts at data and is at least
+  // length bytes long. Only little endian float32 and float64 arrays with one
+  // or two dimensions are supported, a vector is one column. Returns nothing
+  // and logs a warning otherwise
+  static std::optional<Description>
+  describeNpy(const char *data, size_t length, const std::string &path);
+
+  // Writes matrix as a float32 column-major .gmat file. Returns false and logs
+  // a warning if the file could not be written
+  static bool writeGmat(const std::string &path, MatrixRef matrix,
+                        bool columnNorms = true);
+
+  // Writes a * b^T as a float32 column-major .gmat file without forming it in
+  // memory. The product is computed tileCols columns at a time, one tile on
+  // each thread of pool and on the calling thread, and the tiles are written
+  // in order as they are finished. Returns false and logs a warning if the
+  // file could not be written
+  static bool writeGmatProduct(const std::string &path, MatrixRef a,
+                               MatrixRef b, size_t tileCols,
+                               BS::thread_pool *pool = nullptr,
+                               bool columnNorms = true);
+
+  // FNV-1a over 64-bit words, the last word zero padded. Pass the previous
+  // result as hash to continue over another buffer
+  static uint64_t checksum(const void *data, size_t size,
+                           uint64_t hash = 0xcbf29ce484222325ULL) noexcept;
+};
+} // namespace GAMM
+#endif
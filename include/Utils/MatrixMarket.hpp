@@ -0,0 +1,27 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_UTILS_MATRIXMARKET_HPP_
+#define IntelliStream_SRC_UTILS_MATRIXMARKET_HPP_
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "Utils/UtilityFunctions.hpp"
+
+namespace GAMM {
+
+// Reader for Matrix Market (.mtx) text files.
+//
+// Both the array and the coordinate formats are read into a dense Matrix, with
+// real, double, integer or pattern entries and general, symmetric or
+// skew-symmetric storage. Repeated coordinates are summed.
+class MatrixMarket {
+public:
+  // Parses the whole text of a file. Returns nothing and logs a warning if it
+  // is malformed or uses complex entries
+  static std::optional<Matrix> parse(std::string_view text,
+                                     const std::string &path);
+};
+} // namespace GAMM
+#endif
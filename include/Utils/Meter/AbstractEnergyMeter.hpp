@@ -5,6 +5,7 @@
 #include <chrono>
 #include <cstdint>
 #include <memory>
+#include <string>
 #include <string_view>
 #include <vector>
 
@@ -25,6 +26,21 @@ public:
   struct Readings {
     std::vector<uint32_t> current, voltage;
     Duration samplingInterval;
+    // When each sample was taken since sampling started and the energy used
+    // up to it. Meters that leave these empty are assumed to sample exactly
+    // every samplingInterval
+    std::vector<uint64_t> timeNs;
+    std::vector<double> cumulativeJ;
+    // Time at which sampling started
+    std::chrono::steady_clock::time_point startTime{};
+
+    // More cumulative energies, one per sample, e.g. of the energy used by
+    // each phase. writeCSV writes one column for each
+    struct Column {
+      std::string name;
+      std::vector<double> cumulativeJ;
+    };
+    std::vector<Column> columns;
 
     Readings(Duration samplingInterval) : samplingInterval{samplingInterval} {}
 
@@ -0,0 +1,74 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_UTILS_METER_EnergySampler_HPP_
+#define IntelliStream_SRC_UTILS_METER_EnergySampler_HPP_
+#include "Utils/Meter/AbstractEnergyMeter.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace GAMM {
+
+// Samples a power source on its own thread for an energy meter.
+//
+// Samples are stamped with a monotonic clock and kept in a ring buffer
+// allocated up front, so sampling never allocates and memory stays bounded
+// however long the run. Each sample also holds the energy used since sampling
+// started, integrated over the real time between samples, so dropping the
+// oldest samples of a long run loses no energy. The thread wakes up at
+// absolute deadlines, which do not drift as the time taken by each read adds
+// up.
+class EnergySampler {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  struct Measurement {
+    uint32_t voltage, current;
+    // Energy used since the previous measurement (or, for the first one, since
+    // the source was read before start()), for sources that count it
+    // themselves. Otherwise the power is integrated with the trapezoidal rule
+    std::optional<double> energyJ{};
+  };
+  // Returns nothing if the source could not be read
+  typedef std::function<std::optional<Measurement>()> Source;
+
+  static constexpr size_t DEFAULT_CAPACITY = 1 << 16;
+
+  EnergySampler(AbstractEnergyMeter::Duration interval, Source source,
+                size_t capacity = DEFAULT_CAPACITY);
+  EnergySampler(const EnergySampler &) = delete;
+  ~EnergySampler() { stop(); }
+
+  void start();
+  // Returns the samples still held in the ring buffer, oldest first
+  AbstractEnergyMeter::Readings stop();
+
+  bool isSampling() const noexcept { return thread.has_value(); }
+  Clock::time_point startTime() const noexcept { return started; }
+
+private:
+  struct Sample {
+    uint64_t timeNs;
+    uint32_t voltage, current;
+    double cumulativeJ;
+  };
+
+  void run();
+
+  AbstractEnergyMeter::Duration interval;
+  Source source;
+  std::vector<Sample> ring;
+  // Number of samples taken, the last capacity of which are in the ring
+  size_t nsamples{0};
+  Clock::time_point started;
+
+  std::optional<std::thread> thread;
+  std::atomic_bool shouldStop{false};
+};
+} // namespace GAMM
+#endif
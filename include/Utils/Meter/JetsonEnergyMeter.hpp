@@ -3,24 +3,24 @@
 #ifndef IntelliStream_SRC_UTILS_METER_JetsonEnergyMeter_HPP_
 #define IntelliStream_SRC_UTILS_METER_JetsonEnergyMeter_HPP_
 #include "Utils/Meter/AbstractEnergyMeter.hpp"
-#include <atomic>
+#include "Utils/Meter/EnergySampler.hpp"
 #include <chrono>
 #include <cstdint>
 #include <memory>
 #include <optional>
 #include <string_view>
-#include <thread>
 #include <vector>
 
 namespace GAMM {
 class JetsonEnergyMeter : public AbstractEnergyMeter {
 public:
   JetsonEnergyMeter(Duration samplingInterval = Duration(5))
-      : AbstractEnergyMeter(samplingInterval), readings{samplingInterval} {
+      : AbstractEnergyMeter(samplingInterval),
+        sampler{samplingInterval, [this]() { return measure(); }} {
     init();
   }
 
-  ~JetsonEnergyMeter() { stopSampling(); }
+  ~JetsonEnergyMeter();
 
   virtual void startSampling() override;
   virtual Readings stopSampling() override;
@@ -29,13 +29,10 @@ public:
 
 private:
   void init();
-  static void collectData(std::shared_ptr<std::atomic_bool>,
-                          JetsonEnergyMeter *);
+  std::optional<EnergySampler::Measurement> measure();
 
-  int currentFd, voltageFd;
-  Readings readings;
-  std::optional<std::thread> samplingThread;
-  std::shared_ptr<std::atomic<bool>> shouldStop;
+  int currentFd{-1}, voltageFd{-1};
+  EnergySampler sampler;
 };
 } // namespace GAMM
 #endif
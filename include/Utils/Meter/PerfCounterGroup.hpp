@@ -0,0 +1,53 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_UTILS_METER_PerfCounterGroup_HPP_
+#define IntelliStream_SRC_UTILS_METER_PerfCounterGroup_HPP_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace GAMM {
+
+// Hardware counters of the whole process, read with perf_event_open.
+//
+// start() opens the counters on every thread of the process, e.g. the threads
+// of pools created beforehand, and they are inherited by the threads these
+// start afterwards. Only user space is counted, which most kernels allow
+// unprivileged processes to do for themselves. Events the kernel or the CPU
+// do not support are left out of the counts, and if none can be opened
+// start() returns false.
+class PerfCounterGroup {
+public:
+  enum Event { Cycles, Instructions, CacheMisses, BranchMisses, NEVENTS };
+
+  struct Counts {
+    // Scaled up when the kernel had to multiplex the counters
+    std::array<std::optional<uint64_t>, NEVENTS> values{};
+
+    const std::optional<uint64_t> &operator[](Event event) const noexcept {
+      return values[event];
+    }
+    std::optional<double> ipc() const noexcept;
+  };
+
+  static const char *name(Event event) noexcept;
+
+  PerfCounterGroup() = default;
+  PerfCounterGroup(const PerfCounterGroup &) = delete;
+  PerfCounterGroup &operator=(const PerfCounterGroup &) = delete;
+  ~PerfCounterGroup() { close(); }
+
+  bool start();
+  Counts stop();
+
+private:
+  void close() noexcept;
+
+  // File descriptors of each event, one per thread
+  std::array<std::vector<int>, NEVENTS> fds;
+};
+} // namespace GAMM
+#endif
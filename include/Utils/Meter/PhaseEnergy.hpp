@@ -0,0 +1,33 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_UTILS_METER_PhaseEnergy_HPP_
+#define IntelliStream_SRC_UTILS_METER_PhaseEnergy_HPP_
+#include "Utils/Meter/AbstractEnergyMeter.hpp"
+#include "Utils/PhaseProfile.hpp"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace GAMM {
+
+// Splits the energy of readings between the phases a profile's markers say
+// ran at the same time.
+//
+// The energy of each sampling interval is shared between the markers that
+// overlap it, in proportion to how long they overlap it. Parallel workers
+// thus share the energy of an interval, and the time during which no phase
+// ran on any thread (e.g. waiting at barriers with every worker idle) goes to
+// "other".
+class PhaseEnergy {
+public:
+  // Adds one column per phase that ran, one for other and one per merge-tree
+  // level to readings
+  static void attribute(AbstractEnergyMeter::Readings &readings,
+                        const std::vector<PhaseProfile::Marker> &markers);
+
+  // The name and total energy of each column added by attribute
+  static std::vector<std::pair<std::string, double>>
+  totals(const AbstractEnergyMeter::Readings &readings);
+};
+} // namespace GAMM
+#endif
@@ -0,0 +1,60 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_UTILS_METER_RaplEnergyMeter_HPP_
+#define IntelliStream_SRC_UTILS_METER_RaplEnergyMeter_HPP_
+#include "Utils/Meter/AbstractEnergyMeter.hpp"
+#include "Utils/Meter/EnergySampler.hpp"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace GAMM {
+
+// Energy of the CPU packages and their DRAM, read from the RAPL counters
+// exposed by the powercap framework under basePath.
+//
+// Every package zone (intel-rapl:N) and DRAM subzone is read, so machines with
+// several sockets are covered. psys zones, which span the whole platform and
+// so include the packages, are left out. The counters wrap around at
+// max_energy_range_uj, which takes minutes, so sampling every interval is
+// enough to catch each wrap. Zones whose range cannot be read are skipped.
+//
+// RAPL gives neither voltage nor current. Each reading holds the mean power
+// since the previous one as the current drawn at 1V, while the energy itself
+// is taken from the counters as is.
+class RaplEnergyMeter : public AbstractEnergyMeter {
+public:
+  static constexpr auto DEFAULT_BASE_PATH = "/sys/class/powercap";
+
+  RaplEnergyMeter(Duration samplingInterval = Duration(5),
+                  std::string basePath = DEFAULT_BASE_PATH);
+  ~RaplEnergyMeter();
+
+  virtual void startSampling() override;
+  virtual Readings stopSampling() override;
+
+  // Whether basePath holds at least one readable zone
+  static bool canBeUsed(const std::string &basePath = DEFAULT_BASE_PATH);
+
+private:
+  struct Zone {
+    std::string name;
+    int fd;
+    uint64_t maxEnergyUj;
+    uint64_t lastUj;
+  };
+
+  static std::vector<Zone> findZones(const std::string &basePath);
+  // Energy used by all zones since the previous call
+  uint64_t energyDeltaUj();
+
+  std::optional<EnergySampler::Measurement> measure();
+
+  std::vector<Zone> zones;
+  EnergySampler::Clock::time_point lastMeasured;
+  EnergySampler sampler;
+};
+} // namespace GAMM
+#endif
@@ -0,0 +1,77 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_UTILS_NUMA_HPP_
+#define IntelliStream_SRC_UTILS_NUMA_HPP_
+
+#include <cstddef>
+#include <optional>
+#include <ostream>
+#include <sched.h>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "BS_thread_pool.hpp"
+
+namespace GAMM {
+
+// NUMA nodes and their CPUs as reported by sysfs. Machines without
+// /sys/devices/system/node are treated as a single node holding every online
+// CPU.
+class NumaTopology {
+public:
+  struct Node {
+    size_t id;
+    std::vector<size_t> cpus;
+  };
+
+  // Compact fills one node before moving to the next, Scatter alternates
+  // between nodes so that every memory controller is used
+  enum class Placement { Compact, Scatter };
+
+  static NumaTopology
+  discover(std::string_view sysPath = "/sys/devices/system");
+
+  const std::vector<Node> &getNodes() const noexcept { return nodes; }
+  size_t ncpus() const noexcept;
+  std::optional<size_t> nodeOfCpu(size_t cpu) const noexcept;
+
+  // The CPU for each of nthreads threads, wrapping around if there are more
+  // threads than CPUs
+  std::vector<size_t> placement(size_t nthreads, Placement placement) const;
+
+  // Parses a sysfs cpu list such as "0-3,8,10-11"
+  static std::vector<size_t> parseCpuList(std::string_view list);
+
+  static std::optional<Placement> parsePlacement(std::string_view name);
+
+  // Pins the calling thread to the cpu given, if any, while in scope, then
+  // lets it run on the cpus it could before. Threads started meanwhile
+  // inherit the pin, so the scope should only hold the pinned work
+  class PinScope {
+  public:
+    explicit PinScope(std::optional<size_t> cpu);
+    ~PinScope();
+
+    PinScope(const PinScope &) = delete;
+    PinScope &operator=(const PinScope &) = delete;
+
+  private:
+    std::optional<cpu_set_t> previous;
+  };
+
+  // Pins the calling thread to cpu. Returns false if the kernel refused or
+  // cpu does not fit in a cpu_set_t
+  static bool pinCurrentThread(size_t cpu);
+  // Pins each thread of pool to one of cpus after the first, which is left
+  // for the calling thread (see PinScope). Blocks until every pool thread has
+  // been pinned
+  static void pinPool(BS::thread_pool &pool, const std::vector<size_t> &cpus);
+
+private:
+  std::vector<Node> nodes;
+};
+
+std::ostream &operator<<(std::ostream &o, NumaTopology const &topology);
+} // namespace GAMM
+#endif
@@ -0,0 +1,160 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_UTILS_PHASEPROFILE_HPP_
+#define IntelliStream_SRC_UTILS_PHASEPROFILE_HPP_
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// Phase timers are compiled in unless GAMM_PHASE_TIMERS is defined to 0, which
+// the ENABLE_PHASE_TIMERS CMake option does
+#ifndef GAMM_PHASE_TIMERS
+#define GAMM_PHASE_TIMERS 1
+#endif
+
+#if GAMM_PHASE_TIMERS
+// Declares a timer recording into profile, which may be null
+#define GAMM_PHASE_TIMER(name, profile) ::GAMM::PhaseProfile::Timer name{profile}
+// Records the time since the timer was declared or last lapped into phase
+#define GAMM_PHASE_LAP(name, phase)                                            \
+  name.lap(::GAMM::PhaseProfile::Phase::phase)
+#else
+#define GAMM_PHASE_TIMER(name, profile)
+#define GAMM_PHASE_LAP(name, phase)
+#endif
+
+namespace GAMM {
+
+// Time spent in each phase of the reductions of a Bamm, along with the number
+// of times each phase ran and a histogram of their durations.
+//
+// A profile can be shared by the Bamms used by the workers of a parallel
+// strategy. The parts of a sweep can take well under a microsecond, so each
+// thread records into its own shard, whose lock is only contended while the
+// profile is read, and the shards are merged on read.
+//
+// When markers are enabled, each top-level phase that ran is also kept with
+// its start and end times and the merge-tree level of the thread that ran it,
+// so that samples taken over the same time (e.g. of the energy used) can be
+// attributed to phases.
+class PhaseProfile {
+public:
+  enum class Phase : size_t {
+    // Bamm::reductionStepSetup
+    Copy,
+    Qr,
+    Product,
+    // Bamm::reductionStepSvdStep, made of the three phases of each sweep
+    Sweeps,
+    SweepPairs,
+    SweepRotations,
+    SweepApply,
+    // Bamm::reductionStepFinish
+    SvdFinish,
+    Shrink,
+    Update,
+  };
+  typedef std::chrono::steady_clock Clock;
+
+  static constexpr size_t NPHASES = size_t(Phase::Update) + 1;
+  // Bucket i counts the durations in [2^i, 2^(i + 1)) nanoseconds, the last
+  // bucket everything longer
+  static constexpr size_t NBUCKETS = 40;
+
+  struct Stats {
+    uint64_t count{0}, totalNs{0}, maxNs{0};
+    std::array<uint64_t, NBUCKETS> histogram{};
+
+    // Upper bound of the bucket holding the q-th quantile
+    uint64_t quantileNs(double q) const noexcept;
+  };
+
+  // A phase that ran, from start to end, at the given merge-tree level
+  struct Marker {
+    Clock::time_point start, end;
+    Phase phase;
+    uint32_t level;
+  };
+
+  // Sets the merge-tree level of the phases run by this thread while in scope
+  class LevelScope {
+  public:
+    explicit LevelScope(size_t level) noexcept;
+    ~LevelScope();
+
+  private:
+    uint32_t previous;
+  };
+
+  class Timer {
+  public:
+    explicit Timer(PhaseProfile *profile) noexcept
+        : profile{profile}, start{profile != nullptr ? Clock::now()
+                                                     : Clock::time_point{}} {}
+
+    void lap(Phase phase) noexcept {
+      if (profile == nullptr) {
+        return;
+      }
+      auto now = Clock::now();
+      profile->record(phase, start, now);
+      start = now;
+    }
+
+  private:
+    PhaseProfile *profile;
+    Clock::time_point start;
+  };
+
+  PhaseProfile() noexcept;
+
+  void record(Phase phase, Clock::time_point start,
+              Clock::time_point end) noexcept;
+  void reset() noexcept;
+
+  Stats get(Phase phase) const;
+  static std::string_view name(Phase phase) noexcept;
+  // Whether the phase runs within another one, like the parts of a sweep
+  static bool isSubphase(Phase phase) noexcept;
+
+  void setMarkers(bool enabled) noexcept;
+  // The markers recorded since markers were enabled, ordered by start
+  std::vector<Marker> getMarkers() const;
+
+private:
+  // What one thread recorded
+  struct Shard {
+    std::mutex mtx;
+    std::thread::id owner;
+    std::array<Stats, NPHASES> stats{};
+    std::vector<Marker> markers;
+  };
+
+  // The shard of the calling thread, added on its first record
+  Shard &localShard();
+
+  // Tells the profiles apart in the per-thread cache of shards, unlike their
+  // addresses which get reused
+  const uint64_t id;
+  // Guards the list of shards, not their contents
+  mutable std::mutex mtx;
+  std::vector<std::unique_ptr<Shard>> shards;
+  std::atomic_bool markersEnabled{false};
+};
+
+typedef std::shared_ptr<PhaseProfile> PhaseProfilePtr;
+
+// One line per phase that ran: count, total, mean, median and p99. The totals
+// of a shared profile add up the time of every worker
+std::ostream &operator<<(std::ostream &o, PhaseProfile const &profile);
+} // namespace GAMM
+#endif
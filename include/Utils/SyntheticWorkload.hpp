@@ -0,0 +1,54 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_UTILS_SYNTHETICWORKLOAD_HPP_
+#define IntelliStream_SRC_UTILS_SYNTHETICWORKLOAD_HPP_
+
+#include <cstddef>
+#include <ostream>
+#include <utility>
+
+#include "Utils/UtilityFunctions.hpp"
+
+namespace GAMM {
+
+// Generates pairs of matrices x (xRows, cols) and y (yRows, cols) in memory,
+// so that runs can be reproduced without any dataset files.
+//
+// Each matrix is a low rank signal, a (xRows, rank) factor times a power law
+// spectrum times the transpose of a (cols, rank) factor of column
+// coordinates, plus Gaussian noise. The coordinates of y are correlation
+// times those of x plus an independent part, so that correlation controls how
+// large x * y^T is. Entries are then dropped to reach the given density.
+//
+// Everything is drawn from the Mersenne twister of UtilityFunctions seeded
+// with seed, so the same options always give the same matrices.
+class SyntheticWorkload {
+public:
+  struct Options {
+    size_t xRows{1000}, yRows{1000}, cols{10000};
+    size_t rank{50};
+    // The i-th singular value of the signal is (i + 1)^-decay
+    scalar_t decay{1.0};
+    // Standard deviation of the noise, the signal entries having unit variance
+    scalar_t noise{0.01};
+    // Fraction of the entries that are kept
+    scalar_t density{1.0};
+    // Between 0, where x and y have independent coordinates, and 1, where they
+    // share them
+    scalar_t correlation{0.5};
+    unsigned long seed{5489};
+  };
+
+  static std::pair<Matrix, Matrix> generate(const Options &options);
+
+private:
+  // Standard normal sample, by the Box-Muller transform
+  static scalar_t gaussian();
+  static Matrix gaussian(size_t rows, size_t cols);
+  static void addNoiseAndDrop(Matrix &m, const Options &options);
+};
+
+std::ostream &operator<<(std::ostream &o,
+                         SyntheticWorkload::Options const &options);
+} // namespace GAMM
+#endif
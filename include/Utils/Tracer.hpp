@@ -0,0 +1,117 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#ifndef IntelliStream_SRC_UTILS_TRACER_HPP_
+#define IntelliStream_SRC_UTILS_TRACER_HPP_
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Trace scopes are compiled in unless GAMM_TRACING is defined to 0, which the
+// ENABLE_TRACING CMake option does. Even when compiled in, nothing is recorded
+// until Tracer::enable is called
+#ifndef GAMM_TRACING
+#define GAMM_TRACING 1
+#endif
+
+#if GAMM_TRACING
+#define GAMM_TRACE_CONCAT_(a, b) a##b
+#define GAMM_TRACE_CONCAT(a, b) GAMM_TRACE_CONCAT_(a, b)
+// Traces the rest of the enclosing scope as an event with the given name, a
+// string literal, and optionally an integer argument
+#define GAMM_TRACE_SCOPE(...)                                                  \
+  ::GAMM::Tracer::Scope GAMM_TRACE_CONCAT(gammTraceScope, __LINE__) {          \
+    __VA_ARGS__                                                                \
+  }
+#else
+#define GAMM_TRACE_SCOPE(...)
+#endif
+
+namespace GAMM {
+
+// Records when the worker tasks, reduction rounds, SVD sweeps and merges of
+// every thread ran, and writes them as a Chrome trace (JSON) which
+// chrome://tracing and Perfetto can show as a timeline.
+//
+// Each thread appends to its own buffer, allocated on its first event, so
+// recording takes no lock except when the buffer grows. Buffers start small
+// and double up to the capacity, after which further events of their thread
+// are dropped and counted in the trace. A buffer is shrunk to its events when
+// its thread exits. When tracing is not enabled a scope costs a relaxed load.
+class Tracer {
+public:
+  typedef std::chrono::steady_clock Clock;
+
+  static constexpr size_t DEFAULT_CAPACITY = 1 << 16;
+
+  struct Event {
+    const char *name;
+    uint64_t startNs, durationNs;
+    int64_t arg;
+  };
+
+  class Scope {
+  public:
+    explicit Scope(const char *name, int64_t arg = NO_ARG) noexcept
+        : name{name}, arg{arg}, start{Tracer::enabled() ? Clock::now()
+                                                        : Clock::time_point{}} {
+    }
+    ~Scope() {
+      if (start != Clock::time_point{}) {
+        Tracer::record(name, start, Clock::now(), arg);
+      }
+    }
+
+  private:
+    const char *name;
+    int64_t arg;
+    Clock::time_point start;
+  };
+
+  static constexpr int64_t NO_ARG = INT64_MIN;
+
+  // Starts recording the events of every thread, keeping at most capacity per
+  // thread, and writes them to path at exit
+  static void enable(std::string path, size_t capacity = DEFAULT_CAPACITY);
+  static bool enabled() noexcept {
+    return isEnabled.load(std::memory_order_relaxed);
+  }
+
+  static void record(const char *name, Clock::time_point start,
+                     Clock::time_point end, int64_t arg) noexcept;
+
+  // Writes the events recorded so far. Threads may still be recording, their
+  // latest events are then left out
+  static bool write(const std::string &path);
+
+private:
+  static constexpr size_t INITIAL_CAPACITY = 1 << 8;
+
+  struct Buffer {
+    std::vector<Event> events;
+    std::atomic_size_t size{0};
+    std::atomic_size_t dropped{0};
+    size_t tid;
+  };
+
+  static Buffer *threadBuffer();
+  static void writeAtExit();
+
+  static std::atomic_bool isEnabled;
+  // Set by enable before any event is recorded and only read afterwards
+  static std::string outputPath;
+  static size_t bufferCapacity;
+  static Clock::time_point origin;
+  // Buffers outlive the threads that filled them, so that the events of the
+  // threads of pools destroyed before exit are still written. The mutex is
+  // also held while a buffer is resized, which moves its events
+  static std::mutex buffersMutex;
+  static std::vector<std::shared_ptr<Buffer>> buffers;
+};
+} // namespace GAMM
+#endif
@@ -3,6 +3,7 @@
 #ifndef IntelliStream_SRC_UTILS_UTILITYFUNCTIONS_HPP_
 #define IntelliStream_SRC_UTILS_UTILITYFUNCTIONS_HPP_
 #include <Eigen/Dense>
+#include <Eigen/Sparse>
 #include <barrier>
 #include <experimental/filesystem>
 #include <functional>
@@ -22,7 +23,12 @@ typedef float scalar_t;
 typedef std::shared_ptr<std::barrier<>> BarrierPtr;
 typedef Eigen::Matrix<scalar_t, Eigen::Dynamic, Eigen::Dynamic> Matrix;
 typedef std::shared_ptr<Matrix> MatrixPtr;
-typedef Eigen::Block<Matrix, Eigen::Dynamic, Eigen::Dynamic, true> MatrixRef;
+// A read-only view of a column-major matrix, e.g. a block of a Matrix or a
+// memory-mapped file
+typedef Eigen::Ref<const Matrix> MatrixRef;
+typedef Eigen::SparseMatrix<scalar_t, Eigen::ColMajor> SparseMatrix;
+// A read-only view of a range of columns of a compressed SparseMatrix
+typedef Eigen::Map<const SparseMatrix> SparseRef;
 typedef Eigen::DiagonalMatrix<scalar_t, Eigen::Dynamic> DiagonalMatrix;
 typedef Eigen::Matrix<scalar_t, Eigen::Dynamic, 1> Vector;
 
@@ -43,6 +49,10 @@ public:
 
   static scalar_t spectralNorm(const Matrix &mat);
 
+  // Views of a compressed sparse matrix, and of n of its columns from start
+  static SparseRef sparseRef(const SparseMatrix &mat);
+  static SparseRef sparseCols(const SparseRef &mat, size_t start, size_t n);
+
   static uint64_t trailingZeros(uint64_t n);
   static uint64_t leadingZeros(uint64_t n);
   static uint64_t nextPowerOfTwo(uint64_t n);
@@ -0,0 +1,373 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <thread>
+
+#define TOML_EXCEPTIONS 0
+
+#include "toml.hpp"
+
+#include "Amm/AutoBamm.hpp"
+#include "Amm/CombinedParallel.hpp"
+#include "Amm/InterParallel.hpp"
+#include "Amm/IntraParallel.hpp"
+#include "Amm/MergeTree.hpp"
+#include "Amm/Single.hpp"
+#include "Utils/Logger.hpp"
+
+using namespace GAMM;
+
+// Number of timed reduction steps per calibration run
+constexpr size_t CALIBRATION_STEPS = 4;
+
+double AutoBamm::Calibration::parallelSvdMs(size_t nthreads) const noexcept {
+  // Use the largest measured thread count which does not exceed nthreads
+  auto ret = svdMs;
+  for (size_t i = 0; i < threads.size(); ++i) {
+    if (threads[i] <= nthreads) {
+      ret = svdParallelMs[i];
+    }
+  }
+  return ret;
+}
+
+std::string AutoBamm::defaultCalibrationPath() {
+  if (auto cache = std::getenv("XDG_CACHE_HOME")) {
+    return std::string{cache} + "/gamm/calibration.toml";
+  }
+  if (auto home = std::getenv("HOME")) {
+    return std::string{home} + "/.cache/gamm/calibration.toml";
+  }
+  return "gamm-calibration.toml";
+}
+
+std::string AutoBamm::databaseKey() const {
+  std::ostringstream key;
+  key << "l" << l << "-beta"
+      << std::setprecision(std::numeric_limits<scalar_t>::max_digits10) << beta
+      << "-t" << t;
+  return key.str();
+}
+
+const AutoBamm::Calibration &AutoBamm::calibrate() {
+  if (calibration.has_value()) {
+    return calibration.value();
+  }
+
+  calibration = load();
+  if (!calibration.has_value()) {
+    calibration = measure();
+    save(calibration.value());
+  }
+
+  return calibration.value();
+}
+
+AutoBamm::Calibration AutoBamm::measure() const {
+  INTELLI_INFO("Calibrating AutoBamm for l = " << l << ", beta = " << beta
+                                               << ", t = " << t);
+
+  // Enough columns for the first fill plus CALIBRATION_STEPS full steps
+  auto rows = l;
+  auto d = l * (CALIBRATION_STEPS + 2);
+  Matrix x = Matrix::Random(rows, d);
+  Matrix y = Matrix::Random(rows, d);
+
+  struct StepTimes {
+    double linearMs, svdMs, columnsPerStep;
+  };
+
+  auto runSteps = [&](Bamm &bamm, size_t maxSweeps) {
+    auto bx = std::make_shared<Matrix>(Matrix::Zero(rows, l));
+    auto by = std::make_shared<Matrix>(Matrix::Zero(rows, l));
+    bamm.setMatrices(x.leftCols(d), y.leftCols(d), bx, by);
+
+    StepTimes times{0.0, 0.0, 0.0};
+    // BS::timer only has millisecond resolution, which is too coarse here
+    auto timeMs = [](auto &&f) {
+      auto start = std::chrono::steady_clock::now();
+      f();
+      return std::chrono::duration<double, std::milli>(
+                 std::chrono::steady_clock::now() - start)
+          .count();
+    };
+
+    // The first setup only fills the sketch, so it is not counted as absorbing
+    // any columns
+    auto setupMs = timeMs([&] { bamm.reductionStepSetup(); });
+    auto firstFill = bamm.columnsConsumed();
+
+    for (size_t i = 0; i < CALIBRATION_STEPS; ++i) {
+      times.linearMs += setupMs;
+      times.svdMs += timeMs([&] { bamm.reductionStepSvdStep(maxSweeps); });
+      times.linearMs += timeMs([&] { bamm.reductionStepFinish(); });
+      setupMs = timeMs([&] { bamm.reductionStepSetup(); });
+    }
+
+    times.linearMs /= CALIBRATION_STEPS;
+    times.svdMs /= CALIBRATION_STEPS;
+    times.columnsPerStep =
+        std::max(1.0, (double)(bamm.columnsConsumed() - firstFill) /
+                          CALIBRATION_STEPS);
+    return times;
+  };
+
+  Calibration ret;
+
+  Single single(l, beta);
+  auto singleTimes = runSteps(single, single.getMaxSweeps());
+  // Both bx and by have `rows` rows
+  ret.rowNs = singleTimes.linearMs * 1e6 / (2.0 * (double)rows);
+  ret.svdMs = singleTimes.svdMs;
+  ret.columnsPerStep = singleTimes.columnsPerStep;
+
+  // Powers of two below t, and t itself
+  ret.threads.push_back(1);
+  ret.svdParallelMs.push_back(ret.svdMs);
+  for (size_t n = 2; n < 2 * t; n *= 2) {
+    auto nthreads = std::min(n, t);
+    IntraParallel intra(l, beta, pool, nthreads);
+    auto intraTimes = runSteps(intra, AbstractJTS::Options{}.maxSweeps);
+    ret.threads.push_back(nthreads);
+    ret.svdParallelMs.push_back(intraTimes.svdMs);
+  }
+
+  INTELLI_INFO("Calibrated AutoBamm: " << ret.rowNs << "ns per row, "
+                                       << ret.svdMs << "ms per svd, "
+                                       << ret.columnsPerStep
+                                       << " columns per step");
+  return ret;
+}
+
+std::optional<AutoBamm::Calibration> AutoBamm::load() const {
+  if (!std::filesystem::exists(calibrationPath)) {
+    return {};
+  }
+
+  auto res = toml::parse_file(calibrationPath);
+  if (res.failed()) {
+    INTELLI_WARNING("Failed to parse calibration database '"
+                    << calibrationPath << "', recalibrating");
+    return {};
+  }
+
+  auto tbl = res.table();
+
+  // Measurements from a different machine are of no use
+  auto concurrency = tbl["hardware_concurrency"].value<int64_t>();
+  if (!concurrency.has_value() ||
+      concurrency.value() != std::thread::hardware_concurrency()) {
+    return {};
+  }
+
+  auto entry = tbl[databaseKey()];
+  auto rowNs = entry["row_ns"].value<double>();
+  auto svdMs = entry["svd_ms"].value<double>();
+  auto columnsPerStep = entry["columns_per_step"].value<double>();
+  auto threads = entry["threads"].as_array();
+  auto svdParallelMs = entry["svd_parallel_ms"].as_array();
+
+  if (!rowNs.has_value() || !svdMs.has_value() ||
+      !columnsPerStep.has_value() || threads == nullptr ||
+      svdParallelMs == nullptr || threads->size() != svdParallelMs->size()) {
+    return {};
+  }
+
+  Calibration ret;
+  ret.rowNs = rowNs.value();
+  ret.svdMs = svdMs.value();
+  ret.columnsPerStep = columnsPerStep.value();
+  for (size_t i = 0; i < threads->size(); ++i) {
+    ret.threads.push_back((size_t)threads->at(i).value_or<int64_t>(1));
+    ret.svdParallelMs.push_back(svdParallelMs->at(i).value_or(ret.svdMs));
+  }
+
+  INTELLI_INFO("Loaded AutoBamm calibration '" << databaseKey() << "' from "
+                                               << calibrationPath);
+  return ret;
+}
+
+void AutoBamm::save(const Calibration &calibration) const {
+  toml::table tbl;
+
+  // Keep the entries for other parameters
+  if (std::filesystem::exists(calibrationPath)) {
+    auto res = toml::parse_file(calibrationPath);
+    if (!res.failed()) {
+      tbl = std::move(res.table());
+    }
+  }
+
+  toml::array threads, svdParallelMs;
+  for (size_t i = 0; i < calibration.threads.size(); ++i) {
+    threads.push_back((int64_t)calibration.threads[i]);
+    svdParallelMs.push_back(calibration.svdParallelMs[i]);
+  }
+
+  tbl.insert_or_assign("hardware_concurrency",
+                       (int64_t)std::thread::hardware_concurrency());
+  tbl.insert_or_assign(databaseKey(),
+                       toml::table{
+                           {"row_ns", calibration.rowNs},
+                           {"svd_ms", calibration.svdMs},
+                           {"columns_per_step", calibration.columnsPerStep},
+                           {"threads", std::move(threads)},
+                           {"svd_parallel_ms", std::move(svdParallelMs)},
+                       });
+
+  std::error_code ec;
+  auto parent = std::filesystem::path{calibrationPath}.parent_path();
+  if (!parent.empty()) {
+    std::filesystem::create_directories(parent, ec);
+  }
+
+  std::ofstream f{calibrationPath, std::ios::out | std::ios::trunc};
+  if (!f) {
+    INTELLI_WARNING("Failed to write calibration database " << calibrationPath);
+    return;
+  }
+  f << tbl << "\n";
+}
+
+double AutoBamm::predict(const Calibration &calibration, Strategy strategy,
+                         size_t p, size_t mx, size_t my, size_t d) const {
+  auto rows = (double)(mx + my);
+  auto hardwareThreads =
+      std::max<size_t>(std::thread::hardware_concurrency(), 1);
+
+  auto stepMs = [&](size_t nthreads) {
+    return calibration.rowNs * rows / 1e6 +
+           calibration.parallelSvdMs(std::max<size_t>(nthreads, 1));
+  };
+  // A leaf starts from an empty sketch, so its first l columns are free
+  auto leafSteps = [&](double cols) {
+    return std::ceil(std::max(cols - (double)l, 0.0) /
+                     calibration.columnsPerStep);
+  };
+  auto mergeSteps = [&](double cols) {
+    return std::ceil(cols / calibration.columnsPerStep);
+  };
+
+  // Mirrors the partition count chosen by InterParallel and CombinedParallel
+  auto partsFor = [&](size_t n) {
+    return std::min(n, std::max<size_t>(d / l, 1));
+  };
+
+  // Critical path of a tree of `parts` leaves, where the workers of each level
+  // split `budget` threads between them (or use one thread each if !shared)
+  auto treeMs = [&](size_t parts, size_t budget, bool shared) {
+    MergeTree tree{parts, fanIn};
+    auto threadsFor = [&](size_t level) {
+      return shared ? budget / std::max<size_t>(tree.nactive(level), 1) : 1;
+    };
+
+    // Workers only run concurrently as far as the hardware allows
+    auto contention = [&](size_t level) {
+      auto nthreads = tree.nactive(level) * threadsFor(level);
+      return std::max(1.0, (double)nthreads / (double)hardwareThreads);
+    };
+
+    auto ms = leafSteps((double)d / (double)parts) * stepMs(threadsFor(0)) *
+              contention(0);
+    for (size_t level = 1; level < tree.depth(); ++level) {
+      auto nchildren = tree.children(0, level).size();
+      ms += mergeSteps((double)(nchildren * l)) * stepMs(threadsFor(level)) *
+            contention(level);
+    }
+    return ms;
+  };
+
+  switch (strategy) {
+  case Strategy::Single:
+    return leafSteps((double)d) * stepMs(1);
+  case Strategy::Intra:
+    return leafSteps((double)d) * stepMs(t);
+  case Strategy::Inter: {
+    auto parts = partsFor(t);
+    // InterParallel hands over to CombinedParallel when it cannot use t
+    // partitions
+    return (parts < t) ? treeMs(parts, t, true) : treeMs(parts, t, false);
+  }
+  case Strategy::Combined:
+    return treeMs(partsFor(p), t, true);
+  }
+
+  return std::numeric_limits<double>::infinity();
+}
+
+AutoBamm::Choice AutoBamm::choose(size_t mx, size_t my, size_t d) {
+  const auto &cal = calibrate();
+
+  std::vector<Choice> candidates{{Strategy::Single, 1, 0.0}};
+  if (t > 1) {
+    candidates.push_back({Strategy::Intra, 1, 0.0});
+    candidates.push_back({Strategy::Inter, t, 0.0});
+    for (size_t p = 2; p <= t; p *= 2) {
+      candidates.push_back({Strategy::Combined, p, 0.0});
+    }
+  }
+
+  std::optional<Choice> best;
+  for (auto &candidate : candidates) {
+    candidate.predictedMs =
+        predict(cal, candidate.strategy, candidate.p, mx, my, d);
+    INTELLI_DEBUG("AutoBamm candidate " << candidate << ": "
+                                        << candidate.predictedMs << "ms");
+    if (!best.has_value() || candidate.predictedMs < best->predictedMs) {
+      best = candidate;
+    }
+  }
+
+  choice = best;
+  INTELLI_INFO("AutoBamm chose " << choice.value() << " for x(" << mx << ", "
+                                 << d << ") and y(" << my << ", " << d
+                                 << "), predicted "
+                                 << choice.value().predictedMs << "ms");
+  return choice.value();
+}
+
+void AutoBamm::reduce() {
+  auto [strategy, p, predictedMs] =
+      choose(xRows(), yRows(), inputCols());
+
+  BammUPtr bamm;
+  switch (strategy) {
+  case Strategy::Single:
+    bamm = std::make_unique<Single>(l, beta);
+    break;
+  case Strategy::Intra:
+    bamm = std::make_unique<IntraParallel>(l, beta, pool, t);
+    break;
+  case Strategy::Inter:
+    bamm = std::make_unique<InterParallel>(l, beta, pool, fanIn, partitioning);
+    break;
+  case Strategy::Combined:
+    bamm = std::make_unique<CombinedParallel>(l, beta, pool, t, p, fanIn,
+                                              partitioning);
+    break;
+  }
+
+  bamm->setProfile(profile);
+  bamm->setLoadProfile(loadProfile);
+  reduceInputCols(*bamm, 0, inputCols(), bx.value(), by.value());
+}
+
+std::ostream &GAMM::operator<<(std::ostream &o,
+                               AutoBamm::Choice const &choice) {
+  switch (choice.strategy) {
+  case AutoBamm::Strategy::Single:
+    return o << "single";
+  case AutoBamm::Strategy::Intra:
+    return o << "intra";
+  case AutoBamm::Strategy::Inter:
+    return o << "inter";
+  case AutoBamm::Strategy::Combined:
+    return o << "combined-" << choice.p;
+  }
+  return o;
+}
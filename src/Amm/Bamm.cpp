@@ -1,4 +1,7 @@
+#include <cassert>
+
 #include "Amm/Bamm.hpp"
+#include "Svd/AbstractJTS.hpp"
 #include "Utils/Logger.hpp"
 #include "Utils/UtilityFunctions.hpp"
 
@@ -16,11 +19,49 @@ void Bamm::parameterizedReduceRank(DiagonalMatrix &sv) const {
   diagonal = diagonal.cwiseMax(0.0).cwiseSqrt();
 }
 
-bool Bamm::reductionStepSetup() {
-  auto end = std::min(xi + zeroedColumns.nzeroed(), (size_t)x.value().cols());
+void Bamm::reduceInputCols(Bamm &bamm, size_t start, size_t n, MatrixPtr bx,
+                           MatrixPtr by) const {
+  if (isSparse()) {
+    bamm.reduce(UtilityFunctions::sparseCols(sx.value(), start, n),
+                UtilityFunctions::sparseCols(sy.value(), start, n),
+                std::move(bx), std::move(by));
+  } else {
+    bamm.reduce(x.value().middleCols(start, n), y.value().middleCols(start, n),
+                std::move(bx), std::move(by));
+  }
+}
 
-  INTELLI_TRACE("Copying " << (end - xi) << " columns into bx and by");
-  for (; xi < end; ++xi) {
+// Writes the stored entries of column j of m into column col of sketch. col is
+// a zeroed column, so only the stored entries are touched
+static void scatterColumn(const SparseRef &m, size_t j, Matrix &sketch,
+                          size_t col) {
+  assert(sketch.col(col).isZero(0));
+  for (SparseRef::InnerIterator it(m, j); it; ++it) {
+    sketch(it.row(), col) = it.value();
+  }
+}
+
+bool Bamm::reductionStepSetup() {
+  auto cols = inputCols();
+  GAMM_PHASE_TIMER(timer, profile.get());
+
+  INTELLI_TRACE("Copying up to " << zeroedColumns.nzeroed()
+                                 << " columns into bx and by");
+  // Skipped zero columns do not use up a zeroed column of the sketch, so a run
+  // of them does not lead to an SVD of a partially filled sketch
+  for (; xi < cols && zeroedColumns.nzeroed() > 0; ++xi) {
+    if (isSparse()) {
+      // A compressed column is empty when it starts where the next one does
+      auto outer = sx->outerIndexPtr();
+      if (outer[xi] == outer[xi + 1]) {
+        continue;
+      }
+
+      auto zeroCol = zeroedColumns.getNextZeroed();
+      scatterColumn(sx.value(), xi, *bx.value(), zeroCol);
+      scatterColumn(sy.value(), xi, *by.value(), zeroCol);
+      continue;
+    }
 
     if (x.value().col(xi).unaryExpr(std::ref(UtilityFunctions::isZero)).all()) {
 
@@ -34,8 +75,10 @@ bool Bamm::reductionStepSetup() {
     by.value()->col(zeroCol) = y.value().col(xi);
   }
 
+  GAMM_PHASE_LAP(timer, Copy);
+
   // If there are no more columns to copy then exit early
-  if (xi >= (size_t)x.value().cols())
+  if (xi >= cols)
     return true;
 
   Matrix rx = Matrix::Zero(l, l);
@@ -43,18 +86,27 @@ bool Bamm::reductionStepSetup() {
 
   UtilityFunctions::qr(*bx.value(), rx);
   UtilityFunctions::qr(*by.value(), ry_t, true);
+  GAMM_PHASE_LAP(timer, Qr);
 
   rx *= ry_t;
 
   svd->startSvd(std::move(rx));
+  GAMM_PHASE_LAP(timer, Product);
 
   return false;
 }
 
-bool Bamm::reductionStepSvdStep(size_t nsteps) { return svd->svdStep(nsteps); }
+bool Bamm::reductionStepSvdStep(size_t nsteps) {
+  GAMM_PHASE_TIMER(timer, profile.get());
+  auto done = svd->svdStep(nsteps);
+  GAMM_PHASE_LAP(timer, Sweeps);
+  return done;
+}
 
 bool Bamm::reductionStepFinish() {
+  GAMM_PHASE_TIMER(timer, profile.get());
   svd->finishSvd();
+  GAMM_PHASE_LAP(timer, SvdFinish);
 
   auto &sv = svd->singularValues();
   auto &u = svd->matrixU();
@@ -62,18 +114,87 @@ bool Bamm::reductionStepFinish() {
 
   parameterizedReduceRank(sv);
 
-  for (int i = 0; i < sv.cols(); ++i) {
-    const auto &value = sv.diagonal()[i];
+  // The columns of bx are rotated below, so the zeroed columns are exactly
+  // those with a zero singular value. Columns left over from the previous step
+  // (e.g. when only zero columns remained to be copied) must not be kept
+  zeroedColumns.resizeFilled(sv.cols());
+
+  // Walk backwards so that the zeroed columns are handed out in ascending
+  // order, as ZeroedColumns::fromMatrix does. A reduction split over several
+  // calls to reduce() then fills the sketch exactly like a single one
+  for (int i = sv.cols() - 1; i >= 0; --i) {
+    auto &value = sv.diagonal()[i];
 
     if (UtilityFunctions::isZero(value)) {
+      // Make sure the column ends up exactly zero
+      value = 0.0;
       zeroedColumns.setZeroed(i);
     }
 
     u.col(i) *= value;
     v.col(i) *= value;
   }
+  GAMM_PHASE_LAP(timer, Shrink);
 
   *bx.value() *= u;
   *by.value() *= v;
+  GAMM_PHASE_LAP(timer, Update);
   return true;
 }
+
+void Bamm::merge(const std::vector<MatrixPtr> &xs,
+                 const std::vector<MatrixPtr> &ys, MatrixPtr bx,
+                 MatrixPtr by) {
+  INTELLI_ASSERT(xs.size() == ys.size(), "Merging unpaired sketches");
+  auto width = (xs.size() + 1) * l;
+
+  Matrix qx(bx->rows(), width);
+  Matrix qy(by->rows(), width);
+  {
+    GAMM_PHASE_TIMER(timer, profile.get());
+    qx.leftCols(l) = *bx;
+    qy.leftCols(l) = *by;
+    for (size_t j = 0; j < xs.size(); ++j) {
+      qx.middleCols((j + 1) * l, l) = *xs[j];
+      qy.middleCols((j + 1) * l, l) = *ys[j];
+    }
+    GAMM_PHASE_LAP(timer, Copy);
+
+    Matrix rx = Matrix::Zero(width, width);
+    Matrix ry_t = Matrix::Zero(width, width);
+
+    UtilityFunctions::qr(qx, rx);
+    UtilityFunctions::qr(qy, ry_t, true);
+    GAMM_PHASE_LAP(timer, Qr);
+
+    rx *= ry_t;
+
+    svd->startSvd(std::move(rx));
+    GAMM_PHASE_LAP(timer, Product);
+  }
+
+  auto maxSweeps = dynamic_cast<AbstractJTS &>(*svd).getOptions().maxSweeps;
+  INTELLI_VERIFY(reductionStepSvdStep(maxSweeps),
+                 "Running maxSweeps number of steps");
+
+  GAMM_PHASE_TIMER(timer, profile.get());
+  svd->finishSvd();
+  GAMM_PHASE_LAP(timer, SvdFinish);
+
+  // The singular values are sorted, so the l largest are kept and shrunk like
+  // those of an l-wide reduction
+  DiagonalMatrix sv{svd->singularValues().diagonal().head(l)};
+  parameterizedReduceRank(sv);
+  for (size_t i = 0; i < l; ++i) {
+    auto &value = sv.diagonal()[i];
+    if (UtilityFunctions::isZero(value)) {
+      // Make sure the column ends up exactly zero
+      value = 0.0;
+    }
+  }
+  GAMM_PHASE_LAP(timer, Shrink);
+
+  bx->noalias() = qx * (svd->matrixU().leftCols(l) * sv);
+  by->noalias() = qy * (svd->matrixV().leftCols(l) * sv);
+  GAMM_PHASE_LAP(timer, Update);
+}
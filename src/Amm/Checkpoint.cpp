@@ -0,0 +1,158 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <limits>
+
+#include "Amm/Checkpoint.hpp"
+#include "Utils/Logger.hpp"
+#include "Utils/MatrixFile.hpp"
+
+using namespace GAMM;
+
+bool Checkpoint::matches(size_t xRows, size_t yRows, size_t cols, size_t l,
+                         scalar_t beta) const noexcept {
+  return (size_t)bx.rows() == xRows && (size_t)by.rows() == yRows &&
+         this->cols == cols && (size_t)bx.cols() == l &&
+         (size_t)by.cols() == l && this->beta == beta;
+}
+
+bool Checkpoint::save(const std::string &path) const {
+  auto bxSize = bx.size() * sizeof(scalar_t);
+  auto bySize = by.size() * sizeof(scalar_t);
+
+  CheckpointHeader header{};
+  std::memcpy(header.magic, CheckpointHeader::MAGIC, sizeof(header.magic));
+  header.version = CheckpointHeader::VERSION;
+  header.l = bx.cols();
+  header.xRows = bx.rows();
+  header.yRows = by.rows();
+  header.cols = cols;
+  header.nextCol = nextCol;
+  header.beta = beta;
+  header.xHash = xHash;
+  header.yHash = yHash;
+  header.checksum = MatrixFile::checksum(bx.data(), bxSize);
+  header.checksum = MatrixFile::checksum(by.data(), bySize, header.checksum);
+
+  auto temp = path + ".tmp";
+  std::ofstream f(temp, std::ios::out | std::ios::binary | std::ios::trunc);
+  f.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  f.write(reinterpret_cast<const char *>(bx.data()), bxSize);
+  f.write(reinterpret_cast<const char *>(by.data()), bySize);
+  f.close();
+
+  std::error_code ec;
+  if (!f.fail()) {
+    std::filesystem::rename(temp, path, ec);
+  }
+  if (f.fail() || ec) {
+    INTELLI_WARNING("Failed to write checkpoint " << path);
+    std::filesystem::remove(temp, ec);
+    return false;
+  }
+  return true;
+}
+
+std::optional<Checkpoint> Checkpoint::load(const std::string &path) {
+  std::error_code ec;
+  if (!std::filesystem::exists(path, ec)) {
+    return {};
+  }
+
+  auto fail = [&](auto message) -> std::optional<Checkpoint> {
+    INTELLI_WARNING(path << ": " << message);
+    return {};
+  };
+
+  std::ifstream f(path, std::ios::in | std::ios::binary);
+  CheckpointHeader header{};
+  f.read(reinterpret_cast<char *>(&header), sizeof(header));
+  if (f.gcount() != sizeof(header) ||
+      std::memcmp(header.magic, CheckpointHeader::MAGIC,
+                  sizeof(header.magic)) != 0) {
+    return fail("not a checkpoint");
+  }
+  if (header.version != CheckpointHeader::VERSION) {
+    return fail("unsupported version " + std::to_string(header.version));
+  }
+
+  // The sketches are only allocated once the header is known to describe
+  // this file, so a corrupt header cannot ask for an arbitrary amount
+  auto length = std::filesystem::file_size(path, ec);
+  auto maxElements = std::numeric_limits<uint64_t>::max() / sizeof(scalar_t);
+  if (ec || header.l == 0 || header.xRows > maxElements / header.l ||
+      header.yRows > maxElements / header.l - header.xRows ||
+      length != sizeof(header) +
+                    (header.xRows + header.yRows) * header.l *
+                        sizeof(scalar_t)) {
+    return fail("size does not match the header");
+  }
+
+  Checkpoint checkpoint{Matrix(header.xRows, header.l),
+                        Matrix(header.yRows, header.l),
+                        header.cols,
+                        header.nextCol,
+                        (scalar_t)header.beta,
+                        header.xHash,
+                        header.yHash};
+  auto bxSize = checkpoint.bx.size() * sizeof(scalar_t);
+  auto bySize = checkpoint.by.size() * sizeof(scalar_t);
+  f.read(reinterpret_cast<char *>(checkpoint.bx.data()), bxSize);
+  f.read(reinterpret_cast<char *>(checkpoint.by.data()), bySize);
+  if (!f) {
+    return fail("truncated checkpoint");
+  }
+
+  auto sum = MatrixFile::checksum(checkpoint.bx.data(), bxSize);
+  sum = MatrixFile::checksum(checkpoint.by.data(), bySize, sum);
+  if (sum != header.checksum) {
+    return fail("checksum mismatch");
+  }
+
+  return checkpoint;
+}
+
+CheckpointWriter::CheckpointWriter(std::string path) : path{std::move(path)} {
+  writer = std::thread([this]() { writerTask(); });
+}
+
+CheckpointWriter::~CheckpointWriter() {
+  {
+    const std::lock_guard<std::mutex> guard{mtx};
+    stop = true;
+  }
+  submitted.notify_one();
+  writer.join();
+}
+
+void CheckpointWriter::submit(Checkpoint checkpoint) {
+  {
+    const std::lock_guard<std::mutex> guard{mtx};
+    pending = std::move(checkpoint);
+  }
+  submitted.notify_one();
+}
+
+size_t CheckpointWriter::written() const {
+  const std::lock_guard<std::mutex> guard{mtx};
+  return nwritten;
+}
+
+void CheckpointWriter::writerTask() {
+  std::unique_lock<std::mutex> lock{mtx};
+  while (true) {
+    submitted.wait(lock, [this]() { return stop || pending.has_value(); });
+    if (!pending.has_value()) {
+      return;
+    }
+
+    auto checkpoint = std::move(pending.value());
+    pending.reset();
+
+    lock.unlock();
+    auto ok = checkpoint.save(path);
+    lock.lock();
+
+    nwritten += ok;
+  }
+}
@@ -0,0 +1,87 @@
+#include <algorithm>
+#include <numeric>
+
+#include "Amm/ColumnPartitioner.hpp"
+#include "Utils/Logger.hpp"
+
+using namespace GAMM;
+
+ColumnPartitioner::ColumnPartitioner(const MatrixRef &x, size_t parts,
+                                     Mode mode, BS::thread_pool &pool) {
+  INTELLI_ASSERT(parts > 0, "Need at least one partition");
+
+  size_t d = x.cols();
+
+  // nonZero[j] is the number of non-zero columns before column j. Each chunk
+  // marks its own columns, the prefix sum is cheap enough to do afterwards
+  std::vector<size_t> nonZero(d + 1, 0);
+  auto nchunks = std::max<size_t>(std::min<size_t>(pool.get_thread_count() + 1, d), 1);
+
+  auto countChunk = [&](size_t chunk) {
+    auto [start, length] = UtilityFunctions::unevenDivide(chunk, d, nchunks);
+    for (auto j = start; j < start + length; ++j) {
+      nonZero[j + 1] =
+          !x.col(j).unaryExpr(std::ref(UtilityFunctions::isZero)).all();
+    }
+  };
+
+  BS::multi_future<void> tasks(nchunks - 1);
+  for (size_t i = 1; i < nchunks; ++i) {
+    tasks[i - 1] = pool.submit([&countChunk, i]() { countChunk(i); });
+  }
+  countChunk(0);
+  tasks.wait();
+
+  std::partial_sum(nonZero.begin(), nonZero.end(), nonZero.begin());
+  partition(nonZero, parts, mode);
+}
+
+ColumnPartitioner::ColumnPartitioner(const SparseRef &x, size_t parts,
+                                     Mode mode) {
+  INTELLI_ASSERT(parts > 0, "Need at least one partition");
+
+  size_t d = x.cols();
+  auto outer = x.outerIndexPtr();
+
+  std::vector<size_t> nonZero(d + 1, 0);
+  for (size_t j = 0; j < d; ++j) {
+    nonZero[j + 1] = nonZero[j] + (outer[j + 1] != outer[j]);
+  }
+  partition(nonZero, parts, mode);
+}
+
+void ColumnPartitioner::partition(const std::vector<size_t> &nonZero,
+                                  size_t parts, Mode mode) {
+  size_t d = nonZero.size() - 1;
+  auto total = nonZero[d];
+
+  bounds.resize(parts + 1);
+  bounds[parts] = d;
+  for (size_t i = 0; i < parts; ++i) {
+    if (mode == Mode::Even) {
+      bounds[i] = UtilityFunctions::unevenDivide(i, d, parts).start_index;
+    } else {
+      // The first column that has the partition's share of non-zero columns
+      // before it
+      auto target = UtilityFunctions::unevenDivide(i, total, parts).start_index;
+      bounds[i] = std::lower_bound(nonZero.begin(), nonZero.end(), target) -
+                  nonZero.begin();
+    }
+  }
+
+  loads.resize(parts);
+  for (size_t i = 0; i < parts; ++i) {
+    loads[i] = nonZero[bounds[i + 1]] - nonZero[bounds[i]];
+  }
+}
+
+std::ostream &GAMM::operator<<(std::ostream &o,
+                               ColumnPartitioner const &partitioner) {
+  o << "ColumnPartitioner {";
+  for (size_t i = 0; i < partitioner.size(); ++i) {
+    auto [start, length] = partitioner.get(i);
+    o << " [" << start << ", " << start + length
+      << "): " << partitioner.load(i) << ';';
+  }
+  return o << " }";
+}
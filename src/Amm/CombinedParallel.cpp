@@ -1,93 +1,111 @@
-#include <cmath>
-
 #include "Amm/CombinedParallel.hpp"
 #include "Amm/IntraParallel.hpp"
 #include "Utils/Logger.hpp"
+#include "Utils/Tracer.hpp"
 
 using namespace GAMM;
 
 void CombinedParallel::reduce() {
-  std::vector<LockedMatrices> temp{p};
+  auto d = inputCols();
+
+  // Use at most one partition per l columns. The threads of the unused
+  // partitions go to the intra-parallel SVD of the remaining ones
+  auto parts = std::min(p, std::max<size_t>(d / l, 1));
+  if (parts < p) {
+    INTELLI_INFO("Using " << parts << " partitions as " << p << " * " << l
+                          << " > " << d);
+  }
+  tree = MergeTree(parts, tree.getFanIn());
+  barrier.emplace(parts);
+
+  if (isSparse()) {
+    partitions.emplace(sx.value(), parts, partitioning);
+  } else {
+    partitions.emplace(x.value(), parts, partitioning, *pool);
+  }
+  INTELLI_INFO("Leaf partitions (non-zero columns): " << partitions.value());
+
+  std::vector<LockedSketch> temp{parts};
   matrices.swap(temp);
 
   // The bx,by given to worker 1 are the final bx,by computed once
   // inter-parallel bamm is compelete. So we use the bx and by created by the
-  // Bamm super class
+  // Bamm super class. The other workers allocate their own in workerTask
   matrices[0].bx = bx.value();
   matrices[0].by = by.value();
-  for (auto i = matrices.begin() + 1; i != matrices.end(); ++i) {
-    i->bx = std::make_shared<Matrix>(x.value().rows(), l);
-    i->by = std::make_shared<Matrix>(y.value().rows(), l);
-  }
-
-  auto d = x.value().cols();
-  if (p * l > (size_t)d) {
-    INTELLI_WARNING("Not running inter-parallelism due to small size: "
-                    << p << " * " << l << " > " << d);
-    return;
-  }
 
-  BS::multi_future<void> tasks(p - 1);
+  BS::multi_future<void> tasks(parts - 1);
 
-  for (size_t i = 1; i < p; ++i) {
+  loadProfile->begin(parts, tree.depth(), getT());
+  for (size_t i = 1; i < parts; ++i) {
     tasks[i - 1] = pool->submit([this, i]() { workerTask(i); });
   }
   workerTask(0);
   tasks.wait();
+  loadProfile->end();
 
   matrices.clear();
+  partitions.reset();
 }
 
 void CombinedParallel::workerTask(size_t workerId) {
-  auto d = x.value().cols();
-  auto nruns = UtilityFunctions::trailingZeros(
-                   workerId | UtilityFunctions::nextPowerOfTwo(p)) +
-               1;
-
+  GAMM_TRACE_SCOPE("combined worker", int64_t(workerId));
   auto &ownMatrices = matrices[workerId];
   const std::lock_guard<std::mutex> ownGuard{ownMatrices.mtx};
 
+  // Zeroing the sketches here rather than in reduce() means their pages are
+  // first touched by this thread, and so are placed on its NUMA node
+  if (workerId != 0) {
+    ownMatrices.bx = std::make_shared<Matrix>(Matrix::Zero(xRows(), l));
+    ownMatrices.by = std::make_shared<Matrix>(Matrix::Zero(yRows(), l));
+  }
+
   // Wait for all threads to have their own lock first
-  barrier.arrive_and_wait();
+  auto waitStart = LoadProfile::Clock::now();
+  barrier->arrive_and_wait();
+  auto waited = LoadProfile::Clock::now() - waitStart;
+  // Busy time starts once done waiting, so spinning in the waits is left out
+  auto cpuStart = LoadProfile::threadCpuNs();
+
+  auto nlevels = tree.nlevels(workerId);
+  for (size_t i = 0; i < nlevels; ++i) {
+    PhaseProfile::LevelScope level{i};
+    // The leaves reduce a partition of the columns, the other levels merge
+    GAMM_TRACE_SCOPE(i == 0 ? "leaf" : "merge", int64_t(i));
+    auto nthreads = getNumIntraThreads(workerId, i);
 
-  for (size_t i = 0; i < nruns; ++i) {
-    std::optional<MatrixRef> xcols, ycols;
-    std::optional<std::lock_guard<std::mutex>> otherGuard;
-    if (i > 0) {
-      auto otherId = workerId + (1 << (i - 1));
-      if (otherId >= p) {
-        break;
-      }
+    IntraParallel bamm(l, beta, pool, nthreads);
+    bamm.setProfile(profile);
 
-      otherGuard.emplace(matrices[otherId].mtx);
+    if (i > 0) {
+      waitStart = LoadProfile::Clock::now();
+      auto guards = lockChildren(tree, matrices, workerId, i);
+      waited = LoadProfile::Clock::now() - waitStart;
+      cpuStart = LoadProfile::threadCpuNs();
 
-      // leftCols is used create a block pointing to the whole matrix
-      xcols = matrices[otherId].bx->leftCols(l);
-      ycols = matrices[otherId].by->leftCols(l);
+      mergeChildren(bamm, tree, matrices, workerId, i);
     } else {
-      auto [startCol, numCols] = UtilityFunctions::unevenDivide(workerId, d, p);
+      auto [startCol, numCols] = partitions->get(workerId);
 
-      *ownMatrices.bx = x.value().middleCols(startCol, l);
-      *ownMatrices.by = y.value().middleCols(startCol, l);
-
-      // We need nested expression to make the types match
-      xcols =
-          x.value().nestedExpression().middleCols(startCol + l, numCols - l);
-      ycols =
-          y.value().nestedExpression().middleCols(startCol + l, numCols - l);
+      // The sketch starts out zeroed, so the whole partition is reduced into
+      // it
+      reduceInputCols(bamm, startCol, numCols, ownMatrices.bx, ownMatrices.by);
     }
 
-    auto nthreads = getNumIntraThreads(workerId, (int)i);
-
-    IntraParallel bamm(l, beta, pool, nthreads);
-
-    bamm.Bamm::reduce(std::move(xcols.value()), std::move(ycols.value()),
-                      ownMatrices.bx, ownMatrices.by);
+    auto cpuEnd = LoadProfile::threadCpuNs();
+    auto waitNs =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count();
+    // The rest of the worker's team ran on the pool
+    loadProfile->record(workerId, i, cpuEnd - cpuStart + bamm.helperCpuNs(),
+                        waitNs, nthreads);
+    cpuStart = cpuEnd;
   }
 }
 
-size_t CombinedParallel::getNumIntraThreads(size_t workerId, int i) {
-  auto numInterThreads = (size_t)std::ceil((double)p / std::pow(2.0, i) - 0.5);
-  return UtilityFunctions::unevenDivide(workerId, getT(), numInterThreads)
-      .length;
+size_t CombinedParallel::getNumIntraThreads(size_t workerId, size_t level) {
+  // The threads of the leaves workerId to last, which are contiguous
+  auto last = tree.lastLeaf(workerId, level);
+  auto first = UtilityFunctions::unevenDivide(workerId, getT(), tree.getT());
+  auto end = UtilityFunctions::unevenDivide(last, getT(), tree.getT());
+  return end.start_index + end.length - first.start_index;
 }
@@ -144,8 +144,8 @@ void GlobalTaskDispatcher::reduce() {
 Single GlobalTaskDispatcher::getBamm(int id1, int id2) {
     auto &ownMatrices = matrices[id1];
     std::optional<MatrixRef> xcols, ycols;
-    xcols = matrices[id2].bx->leftCols(l);
-    ycols = matrices[id2].by->leftCols(l);
+    xcols.emplace(matrices[id2].bx->leftCols(l));
+    ycols.emplace(matrices[id2].by->leftCols(l));
     Single bamm(l, beta);
     bamm.setMatrices(std::move(xcols.value()), std::move(ycols.value()),
                      ownMatrices.bx, ownMatrices.by);
@@ -1,86 +1,107 @@
+#include "Amm/CombinedParallel.hpp"
 #include "Amm/InterParallel.hpp"
 #include "Amm/Single.hpp"
 #include "Utils/Logger.hpp"
+#include "Utils/Tracer.hpp"
 
 using namespace GAMM;
 
 void InterParallel::reduce() {
   auto t = getT();
+  auto d = inputCols();
+
+  // Use at most one partition per l columns. Leaves with fewer columns than the
+  // sketch would not reduce anything and only add merges
+  auto parts = std::min(t, std::max<size_t>(d / l, 1));
+  if (parts < t) {
+    INTELLI_INFO("Using " << parts << " partitions as " << t << " * " << l
+                          << " > " << d
+                          << ", remaining threads are used for the SVD");
+    // The workers run on the threads of this pool, t - 1 of them
+    CombinedParallel combined(l, beta, pool, t, parts, tree.getFanIn(),
+                              partitioning);
+    combined.setProfile(profile);
+    combined.setLoadProfile(loadProfile);
+    reduceInputCols(combined, 0, d, bx.value(), by.value());
+    return;
+  }
 
-  std::vector<LockedMatrices> temp{t};
+  if (isSparse()) {
+    partitions.emplace(sx.value(), t, partitioning);
+  } else {
+    partitions.emplace(x.value(), t, partitioning, *pool);
+  }
+  INTELLI_INFO("Leaf partitions (non-zero columns): " << partitions.value());
+
+  std::vector<LockedSketch> temp{t};
   matrices.swap(temp);
 
   // The bx,by given to worker 1 are the final bx,by computed once
   // inter-parallel bamm is compelete. So we use the bx and by created by the
-  // Bamm super class
+  // Bamm super class. The other workers allocate their own in workerTask
   matrices[0].bx = bx.value();
   matrices[0].by = by.value();
-  for (auto i = matrices.begin() + 1; i != matrices.end(); ++i) {
-    i->bx = std::make_shared<Matrix>(x.value().rows(), l);
-    i->by = std::make_shared<Matrix>(y.value().rows(), l);
-  }
-
-  auto d = x.value().cols();
-  if (t * l > (size_t)d) {
-    INTELLI_WARNING("Not running inter-parallelism due to small size: "
-                    << t << " * " << l << " > " << d);
-    return;
-  }
 
   BS::multi_future<void> tasks(t - 1);
 
+  loadProfile->begin(t, tree.depth());
   for (size_t i = 1; i < t; ++i) {
     tasks[i - 1] = pool->submit([this, i]() { workerTask(i); });
   }
   workerTask(0);
   tasks.wait();
+  loadProfile->end();
 
   matrices.clear();
+  partitions.reset();
 }
 
 void InterParallel::workerTask(size_t workerId) {
-  auto d = x.value().cols();
-  auto t = getT();
-  auto nruns = UtilityFunctions::trailingZeros(
-                   workerId | UtilityFunctions::nextPowerOfTwo(t)) +
-               1;
-
+  GAMM_TRACE_SCOPE("inter worker", int64_t(workerId));
   auto &ownMatrices = matrices[workerId];
   const std::lock_guard<std::mutex> ownGuard{ownMatrices.mtx};
 
+  // Zeroing the sketches here rather than in reduce() means their pages are
+  // first touched by this thread, and so are placed on its NUMA node
+  if (workerId != 0) {
+    ownMatrices.bx = std::make_shared<Matrix>(Matrix::Zero(xRows(), l));
+    ownMatrices.by = std::make_shared<Matrix>(Matrix::Zero(yRows(), l));
+  }
+
   // Wait for all threads to have their own lock first
+  auto waitStart = LoadProfile::Clock::now();
   barrier.arrive_and_wait();
+  auto waited = LoadProfile::Clock::now() - waitStart;
+  // Busy time starts once done waiting, so spinning in the waits is left out
+  auto cpuStart = LoadProfile::threadCpuNs();
+
+  auto nlevels = tree.nlevels(workerId);
+  for (size_t i = 0; i < nlevels; ++i) {
+    PhaseProfile::LevelScope level{i};
+    // The leaves reduce a partition of the columns, the other levels merge
+    GAMM_TRACE_SCOPE(i == 0 ? "leaf" : "merge", int64_t(i));
+    Single bamm(l, beta);
+    bamm.setProfile(profile);
 
-  for (size_t i = 0; i < nruns; ++i) {
-    std::optional<MatrixRef> xcols, ycols;
-    std::optional<std::lock_guard<std::mutex>> otherGuard;
     if (i > 0) {
-      auto otherId = workerId + (1 << (i - 1));
-      if (otherId >= t) {
-        break;
-      }
+      waitStart = LoadProfile::Clock::now();
+      auto guards = lockChildren(tree, matrices, workerId, i);
+      waited = LoadProfile::Clock::now() - waitStart;
+      cpuStart = LoadProfile::threadCpuNs();
 
-      otherGuard.emplace(matrices[otherId].mtx);
-
-      // leftCols is used create a block pointing to the whole matrix
-      xcols = matrices[otherId].bx->leftCols(l);
-      ycols = matrices[otherId].by->leftCols(l);
+      mergeChildren(bamm, tree, matrices, workerId, i);
     } else {
-      auto [startCol, numCols] = UtilityFunctions::unevenDivide(workerId, d, t);
-
-      *ownMatrices.bx = x.value().middleCols(startCol, l);
-      *ownMatrices.by = y.value().middleCols(startCol, l);
+      auto [startCol, numCols] = partitions->get(workerId);
 
-      // We need nested expression to make the types match
-      xcols =
-          x.value().nestedExpression().middleCols(startCol + l, numCols - l);
-      ycols =
-          y.value().nestedExpression().middleCols(startCol + l, numCols - l);
+      // The sketch starts out zeroed, so the whole partition is reduced into
+      // it
+      reduceInputCols(bamm, startCol, numCols, ownMatrices.bx, ownMatrices.by);
     }
 
-    Single bamm(l, beta);
-
-    bamm.Bamm::reduce(std::move(xcols.value()), std::move(ycols.value()),
-                      ownMatrices.bx, ownMatrices.by);
+    auto cpuEnd = LoadProfile::threadCpuNs();
+    auto waitNs =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(waited).count();
+    loadProfile->record(workerId, i, cpuEnd - cpuStart, waitNs);
+    cpuStart = cpuEnd;
   }
 }
@@ -1,12 +1,17 @@
 #include "Amm/IntraParallel.hpp"
 #include "Svd/ParallelJTS.hpp"
 #include "Utils/Logger.hpp"
+#include "Utils/Tracer.hpp"
 
 using namespace GAMM;
 
 void IntraParallel::reduce() {
   auto maxSweeps = dynamic_cast<ParallelJTS &>(*svd).getOptions().maxSweeps;
-  while (!reductionStepSetup()) {
+  while (true) {
+    GAMM_TRACE_SCOPE("reduction round");
+    if (reductionStepSetup()) {
+      break;
+    }
     INTELLI_VERIFY(reductionStepSvdStep(maxSweeps),
                    "Running maxSweeps number of steps");
     reductionStepFinish();
@@ -0,0 +1,69 @@
+#include <algorithm>
+
+#include "Amm/MergeTree.hpp"
+#include "Utils/Logger.hpp"
+
+using namespace GAMM;
+
+MergeTree::MergeTree(size_t t, size_t fanIn) : t{t}, fanIn{fanIn} {
+  INTELLI_ASSERT(t > 0, "Merge tree needs at least one worker");
+  INTELLI_ASSERT(fanIn >= 2, "Merge tree fan-in must be at least 2");
+}
+
+size_t MergeTree::stride(size_t level) const noexcept {
+  size_t s = 1;
+  for (size_t i = 0; i < level; ++i) {
+    s *= fanIn;
+  }
+  return s;
+}
+
+size_t MergeTree::nlevels(size_t workerId) const noexcept {
+  size_t levels = 1;
+  // At each level the worker merges only if it is aligned to the next stride
+  // and has at least one child in range
+  for (size_t s = 1; workerId % (s * fanIn) == 0 && workerId + s < t;
+       s *= fanIn) {
+    ++levels;
+  }
+  return levels;
+}
+
+std::vector<size_t> MergeTree::children(size_t workerId, size_t level) const {
+  std::vector<size_t> ret;
+  if (level == 0) {
+    return ret;
+  }
+
+  auto s = stride(level - 1);
+  for (size_t j = 1; j < fanIn; ++j) {
+    auto childId = workerId + j * s;
+    if (childId >= t) {
+      break;
+    }
+    ret.push_back(childId);
+  }
+  return ret;
+}
+
+size_t MergeTree::nactive(size_t level) const noexcept {
+  if (level == 0) {
+    return t;
+  }
+
+  auto s = stride(level - 1);
+  if (s >= t) {
+    return 0;
+  }
+  // Number of multiples of s * fanIn that still have a child below t
+  auto span = s * fanIn;
+  return (t - s + span - 1) / span;
+}
+
+size_t MergeTree::rank(size_t workerId, size_t level) const noexcept {
+  return workerId / stride(level);
+}
+
+size_t MergeTree::lastLeaf(size_t workerId, size_t level) const noexcept {
+  return std::min(workerId + stride(level), t) - 1;
+}
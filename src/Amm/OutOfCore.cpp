@@ -0,0 +1,157 @@
+#include <algorithm>
+#include <filesystem>
+#include <tuple>
+#include <utility>
+
+#include "Amm/Checkpoint.hpp"
+#include "Amm/OutOfCore.hpp"
+#include "Amm/SketchCache.hpp"
+#include "Utils/BlockPrefetcher.hpp"
+#include "Utils/Logger.hpp"
+
+using namespace GAMM;
+
+static bool checkShapes(const ColumnBlockReader &x,
+                        const ColumnBlockReader &y) {
+  if (x.cols() != y.cols()) {
+    INTELLI_WARNING(x.getPath() << " has " << x.cols() << " columns but "
+                                << y.getPath() << " has " << y.cols());
+    return false;
+  }
+  return true;
+}
+
+// Hashes the columns of x and y before nextCol, as sketch() does while
+// reducing them. Returns nothing if they cannot be read
+static std::optional<std::pair<uint64_t, uint64_t>>
+hashPrefix(ColumnBlockReader &x, ColumnBlockReader &y, size_t nextCol,
+           size_t blockCols, size_t prefetchDepth) {
+  auto xHash = SketchCache::emptyHash(), yHash = SketchCache::emptyHash();
+  if (nextCol == 0) {
+    return std::pair{xHash, yHash};
+  }
+
+  BlockPrefetcher prefetcher(x, y, blockCols, prefetchDepth);
+  while (auto block = prefetcher.next()) {
+    auto cols = std::min(block->cols, nextCol - block->start);
+    xHash = SketchCache::hashColumns(block->x.leftCols(cols), xHash);
+    yHash = SketchCache::hashColumns(block->y.leftCols(cols), yHash);
+    if (block->start + cols == nextCol) {
+      return std::pair{xHash, yHash};
+    }
+  }
+  return {};
+}
+
+std::optional<Bamm::result> OutOfCore::sketch(ColumnBlockReader &x,
+                                              ColumnBlockReader &y) {
+  if (!checkShapes(x, y)) {
+    return {};
+  }
+
+  auto l = bamm.getL();
+  auto bx = std::make_shared<Matrix>(Matrix::Zero(x.rows(), l));
+  auto by = std::make_shared<Matrix>(Matrix::Zero(y.rows(), l));
+
+  size_t startCol = 0;
+  // Hashes of the columns reduced so far, saved with the checkpoints so that
+  // only a sketch of the same inputs is resumed
+  auto xHash = SketchCache::emptyHash(), yHash = SketchCache::emptyHash();
+  std::optional<CheckpointWriter> writer;
+  if (checkpointPath.has_value()) {
+    auto checkpoint = Checkpoint::load(checkpointPath.value());
+    std::optional<std::pair<uint64_t, uint64_t>> hashes;
+    if (checkpoint.has_value() &&
+        checkpoint->matches(x.rows(), y.rows(), x.cols(), l,
+                            bamm.getBeta()) &&
+        checkpoint->nextCol <= x.cols()) {
+      // The reduced columns are read again, which is far cheaper than
+      // reducing them
+      hashes = hashPrefix(x, y, checkpoint->nextCol, blockCols, prefetchDepth);
+    }
+    if (hashes.has_value() &&
+        hashes.value() == std::pair{checkpoint->xHash, checkpoint->yHash}) {
+      *bx = std::move(checkpoint->bx);
+      *by = std::move(checkpoint->by);
+      startCol = checkpoint->nextCol;
+      std::tie(xHash, yHash) = hashes.value();
+      INTELLI_INFO("Resuming from column " << startCol << " saved in "
+                                           << checkpointPath.value());
+    } else if (checkpoint.has_value()) {
+      INTELLI_WARNING(checkpointPath.value()
+                      << " was saved for other inputs, starting over");
+    }
+    writer.emplace(checkpointPath.value());
+  }
+
+  BlockPrefetcher prefetcher(x, y, blockCols, prefetchDepth, startCol);
+  auto lastCheckpoint = std::chrono::steady_clock::now();
+
+  while (auto block = prefetcher.next()) {
+    // Columns left in the sketch by the previous block are picked up again by
+    // Bamm::reduce, so the blocks are reduced as one stream
+    bamm.reduce(block->x.leftCols(block->cols), block->y.leftCols(block->cols),
+                bx, by);
+    if (writer.has_value()) {
+      xHash = SketchCache::hashColumns(block->x.leftCols(block->cols), xHash);
+      yHash = SketchCache::hashColumns(block->y.leftCols(block->cols), yHash);
+    }
+
+    // Only the copy of the sketches is made here, the writer thread saves it
+    auto now = std::chrono::steady_clock::now();
+    if (writer.has_value() && now - lastCheckpoint >= checkpointInterval) {
+      writer->submit({*bx, *by, x.cols(), block->start + block->cols,
+                      bamm.getBeta(), xHash, yHash});
+      lastCheckpoint = now;
+    }
+  }
+  if (prefetcher.failed()) {
+    return {};
+  }
+
+  if (writer.has_value()) {
+    // Wait for a pending write before removing the file
+    writer.reset();
+    std::error_code ec;
+    std::filesystem::remove(checkpointPath.value(), ec);
+  }
+
+  INTELLI_INFO("Reduced " << x.cols() << " columns in blocks of " << blockCols
+                          << ", " << prefetcher.getStats());
+
+  return Bamm::result{bx, by};
+}
+
+std::optional<MatrixPtr> OutOfCore::multiply(ColumnBlockReader &x,
+                                             ColumnBlockReader &y) {
+  auto res = sketch(x, y);
+  if (!res.has_value()) {
+    return {};
+  }
+
+  auto [bx, by] = res.value();
+  *bx *= by->transpose();
+  return bx;
+}
+
+std::optional<Matrix> OutOfCore::exactProduct(ColumnBlockReader &x,
+                                              ColumnBlockReader &y,
+                                              size_t blockCols,
+                                              size_t prefetchDepth) {
+  if (!checkShapes(x, y)) {
+    return {};
+  }
+
+  Matrix z = Matrix::Zero(x.rows(), y.rows());
+  BlockPrefetcher prefetcher(x, y, blockCols, prefetchDepth);
+
+  while (auto block = prefetcher.next()) {
+    z.noalias() += block->x.leftCols(block->cols) *
+                   block->y.leftCols(block->cols).transpose();
+  }
+  if (prefetcher.failed()) {
+    return {};
+  }
+
+  return z;
+}
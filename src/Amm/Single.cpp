@@ -1,13 +1,18 @@
 #include "Amm/Single.hpp"
 #include "Svd/SequentialJTS.hpp"
 #include "Utils/Logger.hpp"
+#include "Utils/Tracer.hpp"
 
 using namespace GAMM;
 
 void Single::reduce() {
   auto maxSweeps = dynamic_cast<SequentialJTS &>(*svd).getOptions().maxSweeps;
 
-  while (!reductionStepSetup()) {
+  while (true) {
+    GAMM_TRACE_SCOPE("reduction round");
+    if (reductionStepSetup()) {
+      break;
+    }
     INTELLI_VERIFY(reductionStepSvdStep(maxSweeps),
                    "Running maxSweeps number of steps");
     reductionStepFinish();
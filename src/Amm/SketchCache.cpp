@@ -0,0 +1,108 @@
+#include <filesystem>
+#include <iomanip>
+#include <limits>
+#include <sstream>
+#include <vector>
+
+#include "Amm/Checkpoint.hpp"
+#include "Amm/SketchCache.hpp"
+#include "Utils/Logger.hpp"
+#include "Utils/MatrixFile.hpp"
+
+using namespace GAMM;
+
+// Bytes of the matrix hashed by one chunk
+static constexpr size_t CHUNK_SIZE = 1 << 20;
+
+SketchCache::SketchCache(std::string directory, MatrixRef x, MatrixRef y,
+                         BS::thread_pool *pool)
+    : directory{std::move(directory)}, xHash{hash(x, pool)},
+      yHash{hash(y, pool)}, xRows(x.rows()), yRows(y.rows()), cols(x.cols()) {}
+
+uint64_t SketchCache::hash(MatrixRef m, BS::thread_pool *pool) {
+  size_t rows = m.rows(), cols = m.cols();
+  auto colBytes = std::max<size_t>(rows * sizeof(scalar_t), 1);
+  auto chunkCols = std::max<size_t>(CHUNK_SIZE / colBytes, 1);
+  auto nchunks = (cols + chunkCols - 1) / chunkCols;
+
+  std::vector<uint64_t> hashes(nchunks);
+  auto hashChunks = [&](size_t first, size_t n) {
+    for (auto chunk = first; chunk < first + n; ++chunk) {
+      auto start = chunk * chunkCols;
+      auto end = std::min(cols, start + chunkCols);
+      hashes[chunk] = hashColumns(m.middleCols(start, end - start), emptyHash());
+    }
+  };
+
+  size_t nworkers = 1;
+  if (pool != nullptr) {
+    nworkers = std::max<size_t>(
+        std::min<size_t>(pool->get_thread_count() + 1, nchunks), 1);
+  }
+
+  BS::multi_future<void> tasks(nworkers - 1);
+  for (size_t i = 1; i < nworkers; ++i) {
+    auto [first, n] = UtilityFunctions::unevenDivide(i, nchunks, nworkers);
+    tasks[i - 1] = pool->submit(
+        [&hashChunks, first, n]() { hashChunks(first, n); });
+  }
+  auto [first, n] = UtilityFunctions::unevenDivide(0, nchunks, nworkers);
+  hashChunks(first, n);
+  tasks.wait();
+
+  uint64_t shape[2] = {rows, cols};
+  auto h = MatrixFile::checksum(shape, sizeof(shape));
+  return MatrixFile::checksum(hashes.data(), hashes.size() * sizeof(uint64_t),
+                              h);
+}
+
+uint64_t SketchCache::hashColumns(MatrixRef m, uint64_t h) {
+  // Columns are hashed one at a time as m may have an outer stride
+  for (Eigen::Index j = 0; j < m.cols(); ++j) {
+    h = MatrixFile::checksum(m.col(j).data(), m.rows() * sizeof(scalar_t), h);
+  }
+  return h;
+}
+
+uint64_t SketchCache::emptyHash() { return MatrixFile::checksum(nullptr, 0); }
+
+std::string SketchCache::path(const Key &key) const {
+  std::ostringstream name;
+  name << std::hex << std::setfill('0') << std::setw(16) << xHash << '-'
+       << std::setw(16) << yHash << std::dec << "-l" << key.l << "-b"
+       << std::setprecision(std::numeric_limits<scalar_t>::max_digits10)
+       << key.beta << "-t" << key.t << "-p" << key.p << "-k" << key.fanIn
+       << (key.partitioning == ColumnPartitioner::Mode::Balanced ? "-balanced"
+                                                                 : "-even")
+       << '-' << key.strategy << ".ckpt";
+  return (std::filesystem::path{directory} / name.str()).string();
+}
+
+std::optional<Bamm::result> SketchCache::get(const Key &key) const {
+  auto checkpoint = Checkpoint::load(path(key));
+  if (!checkpoint.has_value()) {
+    return {};
+  }
+  if (!checkpoint->matches(xRows, yRows, cols, key.l, key.beta) ||
+      checkpoint->nextCol != cols || checkpoint->xHash != xHash ||
+      checkpoint->yHash != yHash) {
+    INTELLI_WARNING(path(key)
+                    << " does not hold a complete sketch of the inputs");
+    return {};
+  }
+
+  return Bamm::result{std::make_shared<Matrix>(std::move(checkpoint->bx)),
+                      std::make_shared<Matrix>(std::move(checkpoint->by))};
+}
+
+bool SketchCache::put(const Key &key, const Bamm::result &sketch) const {
+  std::error_code ec;
+  std::filesystem::create_directories(directory, ec);
+  if (ec) {
+    INTELLI_WARNING("Cannot create " << directory << ": " << ec.message());
+    return false;
+  }
+
+  return Checkpoint{*sketch.bx, *sketch.by, cols, cols, key.beta, xHash, yHash}
+      .save(path(key));
+}
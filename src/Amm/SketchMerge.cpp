@@ -0,0 +1,26 @@
+#include "Amm/SketchMerge.hpp"
+
+using namespace GAMM;
+
+std::vector<std::unique_lock<std::mutex>>
+GAMM::lockChildren(const MergeTree &tree, std::vector<LockedSketch> &sketches,
+                   size_t workerId, size_t level) {
+  std::vector<std::unique_lock<std::mutex>> guards;
+  for (auto childId : tree.children(workerId, level)) {
+    guards.emplace_back(sketches[childId].mtx);
+  }
+  return guards;
+}
+
+void GAMM::mergeChildren(Bamm &bamm, const MergeTree &tree,
+                         std::vector<LockedSketch> &sketches, size_t workerId,
+                         size_t level) {
+  std::vector<MatrixPtr> xs, ys;
+  for (auto childId : tree.children(workerId, level)) {
+    xs.push_back(sketches[childId].bx);
+    ys.push_back(sketches[childId].by);
+  }
+
+  auto &own = sketches[workerId];
+  bamm.merge(xs, ys, own.bx, own.by);
+}
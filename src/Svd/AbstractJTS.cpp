@@ -28,6 +28,15 @@ AbstractJTS::JacobiRotation::JacobiRotation(ColumnPair columnPair,
   j = columnPair.j;
   k = columnPair.k;
 
+  // The columns are already orthogonal (e.g. both are zero when the matrix is
+  // rank deficient), so no rotation is needed. Computing gamma would give NaN
+  if (columnPair.d == 0.0) {
+    t = 0.0;
+    inv_c = c = 1.0;
+    s = 0.0;
+    return;
+  }
+
   auto gamma = (mat.col(k).squaredNorm() - mat.col(j).squaredNorm()) /
                (2.0 * columnPair.d);
   t = std::copysign(1.0 / (std::abs(gamma) + std::sqrt(1 + gamma * gamma)),
@@ -1,9 +1,12 @@
+#include <algorithm>
 #include <atomic>
 #include <functional>
 
 #include "BS_thread_pool.hpp"
 #include "Svd/ParallelJTS.hpp"
+#include "Utils/LoadProfile.hpp"
 #include "Utils/Logger.hpp"
+#include "Utils/Tracer.hpp"
 #include "Utils/UtilityFunctions.hpp"
 
 using namespace GAMM;
@@ -35,7 +38,12 @@ bool ParallelJTS::svdStep(size_t nsteps) {
   BS::multi_future<void> tasks(t - 1);
 
   for (size_t i = 1; i < t; ++i) {
-    tasks[i - 1] = pool->submit([this, nsteps, i]() { workerTask(i, nsteps); });
+    tasks[i - 1] = pool->submit([this, nsteps, i]() {
+      auto cpuStart = LoadProfile::threadCpuNs();
+      workerTask(i, nsteps);
+      helperCpu.fetch_add(LoadProfile::threadCpuNs() - cpuStart,
+                          std::memory_order_relaxed);
+    });
   }
   auto result = workerTask(0, nsteps);
   tasks.wait();
@@ -44,16 +52,23 @@ bool ParallelJTS::svdStep(size_t nsteps) {
 }
 
 bool ParallelJTS::workerTask(size_t workerId, size_t nsteps) {
+  GAMM_TRACE_SCOPE("svd worker", int64_t(workerId));
   // Do not go past maxSweeps specified by the user
   size_t maxIters = std::min(iterNumber + nsteps, options.maxSweeps);
+  // The main worker times each phase up to the barrier ending it, so the
+  // phases add up to the time of the sweep
+  GAMM_PHASE_TIMER(timer, workerId == 0 ? profile : nullptr);
 
   for (size_t i = iterNumber; i < maxIters; ++i) {
+    GAMM_TRACE_SCOPE("svd sweep", int64_t(i));
+
     // ============  PHASE 1  ============
     // Generate columns on which rotations will be applied
     workerTaskPhase1(workerId);
 
     // Wait for MAIN_WORKER to sort and (possibly) set exit condition
     barrier.arrive_and_wait();
+    GAMM_PHASE_LAP(timer, SweepPairs);
 
     // Barrier takes care of synchronisation, so relaxed ordering is fine
     if (counter.load(std::memory_order_relaxed) == COMPLETED) {
@@ -69,6 +84,7 @@ bool ParallelJTS::workerTask(size_t workerId, size_t nsteps) {
 
     // Wait for all threads to finish generating the Jacobi rotations.
     barrier.arrive_and_wait();
+    GAMM_PHASE_LAP(timer, SweepRotations);
 
     // ============  PHASE 3  ============
     // Apply Jacobi rotations
@@ -78,6 +94,7 @@ bool ParallelJTS::workerTask(size_t workerId, size_t nsteps) {
 
     // Wait for iteration to complete so next iteration can be started
     barrier.arrive_and_wait();
+    GAMM_PHASE_LAP(timer, SweepApply);
   }
 
   if (workerId == 0) {
@@ -136,7 +153,8 @@ void ParallelJTS::workerTaskPhase1(size_t workerId) {
   auto curP = p1.begin() + startI;
   auto mergeToP = p2.begin() + startI;
 
-  for (size_t i = 0; i < nruns; ++i) {
+  size_t i = 0;
+  for (; i < nruns; ++i) {
     auto otherId = workerId + (1 << i);
     if (otherId >= t) {
       break;
@@ -160,11 +178,19 @@ void ParallelJTS::workerTaskPhase1(size_t workerId) {
     nelements += otherLock.second;
   }
 
+  // The worker merging ours expects it in the buffer it would be in after
+  // nruns merges. Those past the last worker were skipped, so when t is not a
+  // power of two it may be in the other one
+  if ((nruns - i) % 2 != 0) {
+    std::copy(curP, curP + nelements, mergeToP);
+    std::swap(curP, mergeToP);
+  }
+
   // Update the count of elements we've merged
   sortLock.second = nelements;
 
   if (workerId == 0) {
-    auto hasCompleted = (getP()[0].d < delta) ? COMPLETED : 0;
+    auto hasCompleted = (getP()[0].d <= delta) ? COMPLETED : 0;
     counter.store(hasCompleted, std::memory_order_relaxed);
   }
 }
@@ -1,4 +1,5 @@
 #include "Utils/Logger.hpp"
+#include "Utils/Tracer.hpp"
 #include "Utils/UtilityFunctions.hpp"
 #include <Svd/SequentialJTS.hpp>
 
@@ -19,6 +20,8 @@ void SequentialJTS::startSvd(Matrix matrix) {
 
 bool SequentialJTS::svdStep() {
   size_t n = u.cols();
+  GAMM_TRACE_SCOPE("svd sweep", int64_t(iterNumber));
+  GAMM_PHASE_TIMER(timer, profile);
 
   p.clear();
   // ====== Phase 1 ======
@@ -36,8 +39,9 @@ bool SequentialJTS::svdStep() {
   std::sort(p.begin(), p.end(), std::greater<ColumnPair>());
 
   p.resize(npivots());
+  GAMM_PHASE_LAP(timer, SweepPairs);
 
-  if (p[0].d < delta) {
+  if (p[0].d <= delta) {
     return true;
   }
   // =====================
@@ -49,6 +53,7 @@ bool SequentialJTS::svdStep() {
   for (auto columnPair : p) {
     q.emplace_back(columnPair, u);
   }
+  GAMM_PHASE_LAP(timer, SweepRotations);
   // =====================
 
   // ====== Phase 3 ======
@@ -58,6 +63,7 @@ bool SequentialJTS::svdStep() {
     rotation.applyTo(u);
     rotation.applyTo(v);
   }
+  GAMM_PHASE_LAP(timer, SweepApply);
   // =====================
 
   // Check if maximum iterations has been reached
@@ -0,0 +1,119 @@
+#include <chrono>
+
+#include "Utils/BlockPrefetcher.hpp"
+#include "Utils/Logger.hpp"
+
+using namespace GAMM;
+
+typedef std::chrono::steady_clock Clock;
+
+static double msSince(Clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(Clock::now() - start)
+      .count();
+}
+
+BlockPrefetcher::BlockPrefetcher(ColumnBlockReader &x, ColumnBlockReader &y,
+                                 size_t blockCols, size_t depth,
+                                 size_t startCol)
+    : x{x}, y{y}, blockCols{blockCols}, startCol{startCol} {
+  INTELLI_ASSERT(depth > 0, "Prefetcher needs at least one buffer");
+  INTELLI_ASSERT(blockCols > 0, "Blocks need at least one column");
+
+  slots.resize(depth);
+  for (size_t i = 0; i < depth; ++i) {
+    slots[i].x.resize(x.rows(), blockCols);
+    slots[i].y.resize(y.rows(), blockCols);
+    freeSlots.push_back(i);
+  }
+
+  reader = std::thread([this]() { readerTask(); });
+}
+
+BlockPrefetcher::~BlockPrefetcher() {
+  {
+    const std::lock_guard<std::mutex> guard{mtx};
+    stop = true;
+  }
+  slotFreed.notify_all();
+  reader.join();
+}
+
+void BlockPrefetcher::readerTask() {
+  for (size_t start = startCol; start < x.cols(); start += blockCols) {
+    size_t slot;
+    {
+      std::unique_lock<std::mutex> lock{mtx};
+      slotFreed.wait(lock, [this]() { return stop || !freeSlots.empty(); });
+      if (stop) {
+        return;
+      }
+      slot = freeSlots.front();
+      freeSlots.pop_front();
+    }
+
+    auto &block = slots[slot];
+    auto bytesBefore = x.bytesRead() + y.bytesRead();
+    auto readStart = Clock::now();
+    auto nx = x.read(start, block.x);
+    auto ny = y.read(start, block.y);
+    auto readMs = msSince(readStart);
+
+    const std::lock_guard<std::mutex> guard{mtx};
+    if (!nx.has_value() || !ny.has_value() || nx.value() != ny.value()) {
+      error = true;
+      break;
+    }
+
+    block.start = start;
+    block.cols = nx.value();
+    stats.blocks++;
+    stats.bytes += x.bytesRead() + y.bytesRead() - bytesBefore;
+    stats.readMs += readMs;
+    readySlots.push_back(slot);
+    blockReady.notify_one();
+  }
+
+  const std::lock_guard<std::mutex> guard{mtx};
+  done = true;
+  blockReady.notify_one();
+}
+
+const BlockPrefetcher::Block *BlockPrefetcher::next() {
+  std::unique_lock<std::mutex> lock{mtx};
+
+  // The consumer is done with the previous block
+  if (current.has_value()) {
+    freeSlots.push_back(current.value());
+    current.reset();
+    slotFreed.notify_one();
+  }
+
+  auto waitStart = Clock::now();
+  blockReady.wait(lock, [this]() { return done || !readySlots.empty(); });
+  stats.waitMs += msSince(waitStart);
+
+  if (readySlots.empty() || error) {
+    return nullptr;
+  }
+
+  current = readySlots.front();
+  readySlots.pop_front();
+  return &slots[current.value()];
+}
+
+bool BlockPrefetcher::failed() const {
+  const std::lock_guard<std::mutex> guard{mtx};
+  return error;
+}
+
+BlockPrefetcher::Stats BlockPrefetcher::getStats() const {
+  const std::lock_guard<std::mutex> guard{mtx};
+  return stats;
+}
+
+std::ostream &GAMM::operator<<(std::ostream &o,
+                               BlockPrefetcher::Stats const &stats) {
+  return o << "read " << stats.bytes / 1e6 << "MB in " << stats.blocks
+           << " blocks at " << stats.throughputMBs() << "MB/s, waited "
+           << stats.waitMs << "ms for reads";
+}
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "Utils/ColumnBlockReader.hpp"
+#include "Utils/Logger.hpp"
+
+using namespace GAMM;
+
+std::optional<ColumnBlockReaderUPtr>
+ColumnBlockReader::open(const std::string &path) {
+  auto description = MatrixFile::describe(path);
+  if (!description.has_value()) {
+    return {};
+  }
+
+  auto fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    INTELLI_WARNING("Cannot open " << path << ": " << std::strerror(errno));
+    return {};
+  }
+  posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+  return ColumnBlockReaderUPtr{
+      new ColumnBlockReader(path, fd, description.value())};
+}
+
+ColumnBlockReader::~ColumnBlockReader() { close(fd); }
+
+bool ColumnBlockReader::readFully(void *buf, size_t size, size_t offset) {
+  auto dst = static_cast<char *>(buf);
+  while (size > 0) {
+    auto n = pread(fd, dst, size, offset);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      INTELLI_WARNING("Failed to read " << path << " at offset " << offset
+                                        << ": "
+                                        << (n == 0 ? "unexpected end of file"
+                                                   : std::strerror(errno)));
+      return false;
+    }
+    dst += n;
+    nbytes += n;
+    size -= n;
+    offset += n;
+  }
+  return true;
+}
+
+std::optional<size_t> ColumnBlockReader::read(size_t start, Matrix &block) {
+  INTELLI_ASSERT((size_t)block.rows() == rows(),
+                 "Block has the wrong number of rows");
+
+  auto n = std::min<size_t>(block.cols(), cols() - std::min(start, cols()));
+  if (n == 0) {
+    return 0;
+  }
+
+  auto dsize = description.dtypeSize();
+  auto isFloat64 = description.dtype == GmatHeader::DType::Float64;
+  auto toScalar = [&](const char *src) -> scalar_t {
+    if (isFloat64) {
+      double value;
+      std::memcpy(&value, src, sizeof(value));
+      return (scalar_t)value;
+    }
+    float value;
+    std::memcpy(&value, src, sizeof(value));
+    return (scalar_t)value;
+  };
+
+  if (description.layout == GmatHeader::Layout::ColumnMajor) {
+    auto offset = description.payloadOffset + start * rows() * dsize;
+    if (!isFloat64) {
+      // The columns are contiguous in both the file and the block
+      if (!readFully(block.data(), n * rows() * dsize, offset)) {
+        return {};
+      }
+      return n;
+    }
+
+    buffer.resize(n * rows() * dsize);
+    if (!readFully(buffer.data(), buffer.size(), offset)) {
+      return {};
+    }
+    for (size_t j = 0; j < n; ++j) {
+      for (size_t i = 0; i < rows(); ++i) {
+        block(i, j) = toScalar(&buffer[(j * rows() + i) * dsize]);
+      }
+    }
+    return n;
+  }
+
+  // Row-major files need one read per row for the block's slice of it
+  buffer.resize(n * dsize);
+  for (size_t i = 0; i < rows(); ++i) {
+    auto offset = description.payloadOffset + (i * cols() + start) * dsize;
+    if (!readFully(buffer.data(), buffer.size(), offset)) {
+      return {};
+    }
+    for (size_t j = 0; j < n; ++j) {
+      block(i, j) = toScalar(&buffer[j * dsize]);
+    }
+  }
+  return n;
+}
@@ -2,7 +2,7 @@
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
-#include <fstream>
+#include <future>
 #include <memory>
 #include <optional>
 #include <string>
@@ -30,11 +30,45 @@ void trySetBin(std::string_view binString, Config::Bins &bins) {
     bins.combined = 1;
   } else if (binString == "dynamic") {
     bins.dynamic = 1;
+  } else if (binString == "auto") {
+    bins.autotune = 1;
   } else {
     INTELLI_WARNING("Unknown strategy " << binString);
   }
 }
 
+void trySetPartition(std::string_view partitionString,
+                     bool &balancedPartitions) {
+  if (partitionString == "balanced") {
+    balancedPartitions = true;
+  } else if (partitionString == "even") {
+    balancedPartitions = false;
+  } else {
+    INTELLI_WARNING("Unknown partitioning " << partitionString);
+  }
+}
+
+template <typename T>
+void trySetList(toml::node_view<toml::node> node, std::vector<T> &list) {
+  if (toml::array *arr = node.as_array()) {
+    list.clear();
+    arr->for_each([&list](auto &&el) {
+      if constexpr (toml::is_number<decltype(el)>) {
+        list.push_back(static_cast<T>(*el));
+      }
+    });
+  }
+}
+
+template <typename T>
+std::ostream &printList(std::ostream &o, const std::vector<T> &list) {
+  o << '[';
+  for (size_t i = 0; i < list.size(); ++i) {
+    o << (i > 0 ? ", " : "") << list[i];
+  }
+  return o << ']';
+}
+
 void Config::useConfigFile(std::string_view path) noexcept {
   auto res = toml::parse_file(path);
 
@@ -66,11 +100,128 @@ void Config::useConfigFile(std::string_view path) noexcept {
     t = tbl_t.value<size_t>().value();
   }
 
+  auto tbl_fan_in = tbl["fan_in"];
+  if (tbl_fan_in.is_integer()) {
+    fanIn = tbl_fan_in.value<size_t>().value();
+  }
+
+  auto tbl_partition = tbl["partition"];
+  if (tbl_partition.is_string()) {
+    trySetPartition(tbl_partition.value<std::string_view>().value(),
+                    balancedPartitions);
+  }
+
   auto tbl_beta = tbl["beta"];
   if (tbl_beta.is_number()) {
     beta = tbl_beta.value<scalar_t>().value();
   }
 
+  auto tbl_block_cols = tbl["block_cols"];
+  if (tbl_block_cols.is_integer()) {
+    blockCols = tbl_block_cols.value<size_t>().value();
+  }
+
+  auto tbl_prefetch_depth = tbl["prefetch_depth"];
+  if (tbl_prefetch_depth.is_integer()) {
+    prefetchDepth = tbl_prefetch_depth.value<size_t>().value();
+  }
+
+  auto tbl_checkpoint = tbl["checkpoint"];
+  if (tbl_checkpoint.is_string()) {
+    checkpointPath = tbl_checkpoint.value<std::string>().value();
+  }
+
+  auto tbl_checkpoint_interval = tbl["checkpoint_interval"];
+  if (tbl_checkpoint_interval.is_integer()) {
+    checkpointInterval = tbl_checkpoint_interval.value<size_t>().value();
+  }
+
+  auto tbl_output = tbl["output"];
+  if (tbl_output.is_string()) {
+    outputPath = tbl_output.value<std::string>().value();
+  }
+
+  auto tbl_tile_cols = tbl["tile_cols"];
+  if (tbl_tile_cols.is_integer()) {
+    tileCols = tbl_tile_cols.value<size_t>().value();
+  }
+
+  if (auto tbl_synthetic = tbl["synthetic"]; tbl_synthetic.is_table()) {
+    auto options = synthetic.value_or(SyntheticWorkload::Options{});
+    options.xRows = tbl_synthetic["rows_x"].value_or(options.xRows);
+    options.yRows = tbl_synthetic["rows_y"].value_or(options.yRows);
+    options.cols = tbl_synthetic["cols"].value_or(options.cols);
+    options.rank = tbl_synthetic["rank"].value_or(options.rank);
+    options.decay = tbl_synthetic["decay"].value_or(options.decay);
+    options.noise = tbl_synthetic["noise"].value_or(options.noise);
+    options.density = tbl_synthetic["density"].value_or(options.density);
+    options.correlation =
+        tbl_synthetic["correlation"].value_or(options.correlation);
+    options.seed = tbl_synthetic["seed"].value_or(options.seed);
+    synthetic = options;
+  }
+
+  auto tbl_sweep = tbl["sweep"];
+  if (tbl_sweep.is_string()) {
+    sweepPath = tbl_sweep.value<std::string>().value();
+  }
+  trySetList(tbl["sweep_t"], sweepThreads);
+  trySetList(tbl["sweep_p"], sweepP);
+  trySetList(tbl["sweep_l"], sweepL);
+  trySetList(tbl["sweep_beta"], sweepBeta);
+  trySetList(tbl["sweep_cols"], sweepCols);
+  trySetList(tbl["sweep_rows"], sweepRows);
+
+  auto tbl_sweep_weak = tbl["sweep_weak"];
+  if (tbl_sweep_weak.is_boolean()) {
+    sweepWeak = tbl_sweep_weak.value<bool>().value();
+  }
+
+  auto tbl_warmups = tbl["warmups"];
+  if (tbl_warmups.is_integer()) {
+    warmups = tbl_warmups.value<size_t>().value();
+  }
+
+  auto tbl_repetitions = tbl["repetitions"];
+  if (tbl_repetitions.is_integer()) {
+    repetitions = tbl_repetitions.value<size_t>().value();
+  }
+
+  auto tbl_sketch_cache = tbl["sketch_cache"];
+  if (tbl_sketch_cache.is_string()) {
+    sketchCache = tbl_sketch_cache.value<std::string>().value();
+  }
+
+  auto tbl_perf_counters = tbl["perf_counters"];
+  if (tbl_perf_counters.is_boolean()) {
+    perfCounters = tbl_perf_counters.value<bool>().value();
+  }
+
+  auto tbl_phases = tbl["phases"];
+  if (tbl_phases.is_boolean()) {
+    printPhases = tbl_phases.value<bool>().value();
+  }
+
+  auto tbl_trace = tbl["trace"];
+  if (tbl_trace.is_string()) {
+    tracePath = tbl_trace.value<std::string>().value();
+  }
+
+  auto tbl_sparse = tbl["sparse"];
+  if (tbl_sparse.is_boolean()) {
+    sparse = tbl_sparse.value<bool>().value();
+  }
+
+  auto tbl_calibration = tbl["calibration"];
+  if (tbl_calibration.is_string()) {
+    calibrationPath = tbl_calibration.value<std::string>().value();
+  }
+
+  auto tbl_pin_threads = tbl["pin_threads"];
+  if (tbl_pin_threads.is_string()) {
+    pinThreads = tbl_pin_threads.value<std::string>().value();
+  }
+
   auto tbl_bin = tbl["bin"];
   if (tbl_bin.is_string()) {
     trySetBin(tbl_bin.value<std::string_view>().value(), bins);
@@ -91,13 +242,71 @@ Config::Config(int argc, const char *const argv[]) {
     ("t,t", po::value<size_t>(), "set number of threads to be spawned")
     ("l,l", po::value<size_t>(), "set value for l used in beta-AMM")
     ("beta", po::value<scalar_t>(), "set value for beta used in beta-AMM")
+    ("fan-in,k", po::value<size_t>(), "number of sketches combined by each merge of the "
+                                      "inter-parallel reduction tree")
+    ("partition", po::value<std::string>(), "how the columns are split between inter-parallel "
+                                            "leaves, balanced (by non-zero columns) or even")
     ("x,x", po::value<std::string>(), "path to the matrix X")
     ("y,y", po::value<std::string>(), "path to the matrix Y")
+    ("synthetic", "generate x and y in memory instead of reading them, see the synthetic-* "
+                  "options")
+    ("synthetic-rows-x", po::value<size_t>(), "number of rows of the generated x")
+    ("synthetic-rows-y", po::value<size_t>(), "number of rows of the generated y")
+    ("synthetic-cols", po::value<size_t>(), "number of columns of the generated x and y")
+    ("synthetic-rank", po::value<size_t>(), "rank of the signal in the generated x and y")
+    ("synthetic-decay", po::value<scalar_t>(), "the i-th singular value of the signal is "
+                                               "(i + 1)^-decay")
+    ("synthetic-noise", po::value<scalar_t>(), "standard deviation of the noise added to the "
+                                               "signal, whose entries have unit variance")
+    ("synthetic-density", po::value<scalar_t>(), "fraction of the generated entries kept")
+    ("synthetic-correlation", po::value<scalar_t>(), "how much of their column coordinates x "
+                                                     "and y share, between 0 and 1")
+    ("synthetic-seed", po::value<unsigned long>(), "seed of the generator")
+    ("block-cols", po::value<size_t>(), "sketch x and y out of core, reading this many columns "
+                                        "at a time")
+    ("prefetch-depth", po::value<size_t>(), "number of blocks buffered by the out of core reader, "
+                                            "1 disables read-ahead")
+    ("checkpoint", po::value<std::string>(), "save the out of core sketch to this file and resume "
+                                             "from it")
+    ("checkpoint-interval", po::value<size_t>(), "seconds between two checkpoints")
+    ("output,o", po::value<std::string>(), "directory to write the approximate product of each "
+                                           "amm to, as <name>.gmat")
+    ("tile-cols", po::value<size_t>(), "number of columns of the product computed and written "
+                                       "at a time")
+    ("sketch-cache", po::value<std::string>(), "directory of sketches reused across runs over the "
+                                               "same in memory inputs")
+    ("sweep", po::value<std::string>(), "run every combination of the sweep-* values and write "
+                                        "the results to this .json or .csv file")
+    ("sweep-t", po::value<std::vector<size_t>>()->multitoken(), "numbers of threads to sweep")
+    ("sweep-p", po::value<std::vector<size_t>>()->multitoken(), "values of p to sweep for the "
+                                                                "combined strategy")
+    ("sweep-l", po::value<std::vector<size_t>>()->multitoken(), "values of l to sweep")
+    ("sweep-beta", po::value<std::vector<scalar_t>>()->multitoken(), "values of beta to sweep")
+    ("sweep-cols", po::value<std::vector<size_t>>()->multitoken(), "numbers of columns of x and "
+                                                                   "y to sweep")
+    ("sweep-rows", po::value<std::vector<size_t>>()->multitoken(), "numbers of rows of x and y "
+                                                                   "to sweep")
+    ("sweep-weak", "take sweep-cols per thread, for weak scaling")
+    ("warmups", po::value<size_t>(), "untimed runs of each combination of a sweep")
+    ("repetitions", po::value<size_t>(), "timed runs of each combination of a sweep")
+    ("perf-counters", "count cycles, instructions, cache and branch misses of each amm with "
+                      "perf_event_open")
+    ("phases", "print the time spent in each phase of the reductions of each amm, and their "
+               "energy when measuring energy")
+    ("trace", po::value<std::string>(), "write a timeline of the tasks and phases of each amm to "
+                                        "this file at exit, for chrome://tracing or Perfetto")
+    ("sparse", "reduce sparse copies of x and y, which skips their zero entries")
     ("bin,b", po::value<std::vector<std::string>>(), "binaries to run")
     ("defaults,d", po::value<std::string>(), "config file to use for defaults")
     ("measure-energy,e", "whether to measure the energy consumed by each amm")
-    ("energy-csv,c", po::value<std::string>(), "path to a csv to write detailed energy readings. "
-                                               "Automatically enables measure-energy");
+    ("energy-csv,c", po::value<std::string>(), "path to a csv to write detailed energy readings, "
+                                               "split by phase and merge-tree level. "
+                                               "Automatically enables measure-energy")
+    ("calibration", po::value<std::string>(), "path to the calibration database used by the auto "
+                                              "strategy")
+    ("pin-threads", po::value<std::string>()->implicit_value("scatter"),
+                    "pin threads to cpus, filling one NUMA node at a time (compact) or "
+                    "alternating between nodes (scatter)");
   // clang-format on
 
   po::variables_map vm;
@@ -122,6 +331,14 @@ Config::Config(int argc, const char *const argv[]) {
     l = vm["l"].as<size_t>();
   }
 
+  if (vm.count("fan-in")) {
+    fanIn = vm["fan-in"].as<size_t>();
+  }
+
+  if (vm.count("partition")) {
+    trySetPartition(vm["partition"].as<std::string>(), balancedPartitions);
+  }
+
   if (vm.count("beta")) {
     beta = vm["beta"].as<scalar_t>();
   }
@@ -134,6 +351,112 @@ Config::Config(int argc, const char *const argv[]) {
     y = vm["y"].as<std::string>();
   }
 
+  if (vm.count("block-cols")) {
+    blockCols = vm["block-cols"].as<size_t>();
+  }
+
+  if (vm.count("prefetch-depth")) {
+    prefetchDepth = vm["prefetch-depth"].as<size_t>();
+  }
+
+  if (vm.count("checkpoint")) {
+    checkpointPath = vm["checkpoint"].as<std::string>();
+  }
+
+  if (vm.count("checkpoint-interval")) {
+    checkpointInterval = vm["checkpoint-interval"].as<size_t>();
+  }
+
+  if (vm.count("output")) {
+    outputPath = vm["output"].as<std::string>();
+  }
+
+  if (vm.count("tile-cols")) {
+    tileCols = vm["tile-cols"].as<size_t>();
+  }
+
+  // Any of the synthetic-* options implies synthetic
+  auto options = synthetic.value_or(SyntheticWorkload::Options{});
+  auto useSynthetic = vm.count("synthetic") > 0;
+  auto syntheticOption = [&](const char *name, auto &value) {
+    if (vm.count(name)) {
+      value = vm[name].as<std::remove_reference_t<decltype(value)>>();
+      useSynthetic = true;
+    }
+  };
+  syntheticOption("synthetic-rows-x", options.xRows);
+  syntheticOption("synthetic-rows-y", options.yRows);
+  syntheticOption("synthetic-cols", options.cols);
+  syntheticOption("synthetic-rank", options.rank);
+  syntheticOption("synthetic-decay", options.decay);
+  syntheticOption("synthetic-noise", options.noise);
+  syntheticOption("synthetic-density", options.density);
+  syntheticOption("synthetic-correlation", options.correlation);
+  syntheticOption("synthetic-seed", options.seed);
+  if (useSynthetic) {
+    synthetic = options;
+  }
+
+  if (vm.count("sweep")) {
+    sweepPath = vm["sweep"].as<std::string>();
+  }
+
+  if (vm.count("sweep-t")) {
+    sweepThreads = vm["sweep-t"].as<std::vector<size_t>>();
+  }
+
+  if (vm.count("sweep-p")) {
+    sweepP = vm["sweep-p"].as<std::vector<size_t>>();
+  }
+
+  if (vm.count("sweep-l")) {
+    sweepL = vm["sweep-l"].as<std::vector<size_t>>();
+  }
+
+  if (vm.count("sweep-beta")) {
+    sweepBeta = vm["sweep-beta"].as<std::vector<scalar_t>>();
+  }
+
+  if (vm.count("sweep-cols")) {
+    sweepCols = vm["sweep-cols"].as<std::vector<size_t>>();
+  }
+
+  if (vm.count("sweep-rows")) {
+    sweepRows = vm["sweep-rows"].as<std::vector<size_t>>();
+  }
+
+  if (vm.count("sweep-weak")) {
+    sweepWeak = true;
+  }
+
+  if (vm.count("warmups")) {
+    warmups = vm["warmups"].as<size_t>();
+  }
+
+  if (vm.count("repetitions")) {
+    repetitions = vm["repetitions"].as<size_t>();
+  }
+
+  if (vm.count("sketch-cache")) {
+    sketchCache = vm["sketch-cache"].as<std::string>();
+  }
+
+  if (vm.count("perf-counters")) {
+    perfCounters = true;
+  }
+
+  if (vm.count("phases")) {
+    printPhases = true;
+  }
+
+  if (vm.count("trace")) {
+    tracePath = vm["trace"].as<std::string>();
+  }
+
+  if (vm.count("sparse")) {
+    sparse = true;
+  }
+
   if (vm.count("bin")) {
     for (const auto &bin : vm["bin"].as<std::vector<std::string>>()) {
       trySetBin(bin, bins);
@@ -149,50 +472,39 @@ Config::Config(int argc, const char *const argv[]) {
     measureEnergy = true;
   }
 
-  if (bins.isEmpty()) {
-    bins = RUN_ALL;
+  if (vm.count("calibration")) {
+    calibrationPath = vm["calibration"].as<std::string>();
   }
-}
 
-uint64_t readInt(std::ifstream &f) {
-  uint8_t buf[8];
-  f.read((char *)buf, 8);
-  auto ret{0};
-  for (int i = 0; i < 8; ++i) {
-    ret = ret | (buf[i] << (8 * i));
+  if (vm.count("pin-threads")) {
+    pinThreads = vm["pin-threads"].as<std::string>();
   }
-  return ret;
-}
 
-float readFloat(std::ifstream &f) {
-  float val;
-  f.read((char *)&val, sizeof(val));
-  return val;
+  if (bins.isEmpty()) {
+    bins = RUN_ALL;
+  }
 }
 
-std::optional<std::shared_ptr<Matrix>> loadMatrix(const char *file) {
-  std::ifstream f(file, std::ios::in | std::ios::binary);
-  auto n = readInt(f);
-  auto m = readInt(f);
-
-  auto mat = std::make_shared<Matrix>(n, m);
-
-  for (uint64_t i = 0; i != n; ++i) {
-    for (uint64_t j = 0; j != m; ++j) {
-      (*mat)(i, j) = (scalar_t)readFloat(f);
-    }
+std::optional<Config::matrices> Config::loadMatrices() const noexcept {
+  if (synthetic.has_value()) {
+    auto [x, y] = SyntheticWorkload::generate(synthetic.value());
+    return matrices{std::make_shared<const MappedMatrix>(std::move(x)),
+                    std::make_shared<const MappedMatrix>(std::move(y))};
   }
 
-  if (f.fail()) {
-    return {};
+  // X is loaded on its own thread while Y is loaded on this one, and both
+  // convert their ranges using the same pool
+  std::optional<BS::thread_pool> pool;
+  if (t > 1) {
+    pool.emplace(t - 1);
   }
+  auto poolPtr = pool.has_value() ? &pool.value() : nullptr;
 
-  return mat;
-}
-
-std::optional<Config::matrices> Config::loadMatrices() const noexcept {
-  auto x = loadMatrix(this->x.c_str());
-  auto y = loadMatrix(this->y.c_str());
+  auto xFuture = std::async(std::launch::async, [this, poolPtr]() {
+    return MappedMatrix::open(this->x, false, poolPtr);
+  });
+  auto y = MappedMatrix::open(this->y, false, poolPtr);
+  auto x = xFuture.get();
 
   if (!x.has_value() || !y.has_value()) {
     return {};
@@ -234,6 +546,12 @@ std::ostream &GAMM::operator<<(std::ostream &o, Config::Bins const &bins) {
     }
     o << "dynamic";
   }
+  if (bins.autotune) {
+    if (nbins++) {
+      o << " | ";
+    }
+    o << "auto";
+  }
 
   if (nbins == 0) {
     o << "none";
@@ -243,12 +561,38 @@ std::ostream &GAMM::operator<<(std::ostream &o, Config::Bins const &bins) {
 }
 
 std::ostream &GAMM::operator<<(std::ostream &o, Config const &config) {
-  return o << "Config { x: " << config.x << ", y: " << config.y
-           << ", l: " << config.l << ", t: " << config.t
-           << ", beta: " << config.beta << ", bins: " << config.bins
+  o << "Config { x: " << config.x << ", y: " << config.y;
+  if (config.synthetic.has_value()) {
+    o << ", synthetic: " << config.synthetic.value();
+  }
+  if (config.sweepPath.has_value()) {
+    o << ", sweep: " << config.sweepPath.value() << ", sweep-t: ";
+    printList(o, config.sweepThreads) << ", sweep-p: ";
+    printList(o, config.sweepP) << ", sweep-l: ";
+    printList(o, config.sweepL) << ", sweep-beta: ";
+    printList(o, config.sweepBeta) << ", sweep-cols: ";
+    printList(o, config.sweepCols) << ", sweep-rows: ";
+    printList(o, config.sweepRows)
+        << ", sweep-weak: " << (config.sweepWeak ? "true" : "false")
+        << ", warmups: " << config.warmups
+        << ", repetitions: " << config.repetitions;
+  }
+  return o << ", l: " << config.l << ", t: " << config.t
+           << ", fan-in: " << config.fanIn << ", partition: "
+           << (config.balancedPartitions ? "balanced" : "even")
+           << ", beta: " << config.beta << ", block-cols: " << config.blockCols
+           << ", prefetch-depth: " << config.prefetchDepth
+           << ", checkpoint: " << config.checkpointPath.value_or("none")
+           << ", sparse: " << (config.sparse ? "true" : "false")
+           << ", output: " << config.outputPath.value_or("none")
+           << ", sketch-cache: " << config.sketchCache.value_or("none")
+           << ", perf-counters: " << (config.perfCounters ? "true" : "false")
+           << ", phases: " << (config.printPhases ? "true" : "false")
+           << ", trace: " << config.tracePath.value_or("none")
+           << ", bins: " << config.bins
            << ", measure-energy: " << (config.measureEnergy ? "true" : "false")
            << ", energy-csv-file: "
            << (config.energyCSVPath.has_value() ? config.energyCSVPath.value()
                                                 : "none")
-           << " }";
+           << ", pin-threads: " << config.pinThreads.value_or("none") << " }";
 }
@@ -0,0 +1,121 @@
+#include <algorithm>
+#include <ctime>
+#include <iomanip>
+
+#include "Utils/LoadProfile.hpp"
+
+using namespace GAMM;
+
+void LoadProfile::begin(size_t nworkers, size_t nlevels, size_t nthreads) {
+  if (workers.size() < nworkers) {
+    workers.resize(nworkers);
+  }
+  for (auto &levels : workers) {
+    if (levels.size() < nlevels) {
+      levels.resize(nlevels);
+    }
+  }
+  running = nthreads > 0 ? nthreads : nworkers;
+  started = Clock::now();
+}
+
+void LoadProfile::end() {
+  capacityNs += running * std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              Clock::now() - started)
+                              .count();
+  running = 0;
+}
+
+void LoadProfile::record(size_t worker, size_t level, uint64_t busyNs,
+                         uint64_t waitNs, size_t threads) noexcept {
+  auto &stats = workers[worker][level];
+  stats.busyNs += busyNs;
+  stats.waitNs += waitNs;
+  ++stats.tasks;
+  stats.threads = std::max<uint64_t>(stats.threads, threads);
+}
+
+void LoadProfile::reset() noexcept {
+  workers.clear();
+  capacityNs = 0;
+  running = 0;
+}
+
+size_t LoadProfile::nlevels() const noexcept {
+  return workers.empty() ? 0 : workers.front().size();
+}
+
+uint64_t LoadProfile::busyNs(size_t worker) const noexcept {
+  uint64_t total = 0;
+  for (const auto &level : workers[worker]) {
+    total += level.busyNs;
+  }
+  return total;
+}
+
+double LoadProfile::imbalance() const noexcept {
+  uint64_t max = 0, total = 0;
+  for (size_t i = 0; i < nworkers(); ++i) {
+    auto busy = busyNs(i);
+    max = std::max(max, busy);
+    total += busy;
+  }
+  if (total == 0) {
+    return 1;
+  }
+  return double(max) * nworkers() / total;
+}
+
+double LoadProfile::idleFraction() const noexcept {
+  if (capacityNs == 0) {
+    return 0;
+  }
+  uint64_t total = 0;
+  for (size_t i = 0; i < nworkers(); ++i) {
+    total += busyNs(i);
+  }
+  return std::max(1 - double(total) / capacityNs, 0.0);
+}
+
+uint64_t LoadProfile::threadCpuNs() noexcept {
+  timespec ts;
+  if (clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts) != 0) {
+    return 0;
+  }
+  return uint64_t(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+std::ostream &GAMM::operator<<(std::ostream &o, LoadProfile const &load) {
+  o << "imbalance " << std::fixed << std::setprecision(3) << load.imbalance()
+    << ", idle " << std::setprecision(1) << load.idleFraction() * 100
+    << "%\n";
+
+  for (size_t level = 0; level < load.nlevels(); ++level) {
+    uint64_t tasks = 0, threads = 0, busy = 0, maxBusy = 0, wait = 0,
+             maxWait = 0, active = 0;
+    for (size_t i = 0; i < load.nworkers(); ++i) {
+      const auto &stats = load.get(i, level);
+      if (stats.tasks == 0) {
+        continue;
+      }
+      ++active;
+      tasks += stats.tasks;
+      threads += stats.threads;
+      busy += stats.busyNs;
+      maxBusy = std::max(maxBusy, stats.busyNs);
+      wait += stats.waitNs;
+      maxWait = std::max(maxWait, stats.waitNs);
+    }
+    if (active == 0) {
+      continue;
+    }
+
+    o << "level " << std::setw(2) << level << std::setw(6) << tasks
+      << " tasks," << std::setw(4) << threads << " threads, busy "
+      << std::setprecision(3) << std::setw(10) << busy / 1e6 << "ms (max "
+      << std::setw(10) << maxBusy / 1e6 << "ms, mean " << std::setw(10)
+      << busy / 1e6 / active << "ms), wait " << std::setw(10) << wait / 1e6
+      << "ms (max " << std::setw(10) << maxWait / 1e6 << "ms)\n";
+  }
+  return o << std::defaultfloat;
+}
@@ -0,0 +1,315 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <type_traits>
+#include <unistd.h>
+
+#include "Utils/Logger.hpp"
+#include "Utils/MappedMatrix.hpp"
+#include "Utils/MatrixFile.hpp"
+#include "Utils/MatrixMarket.hpp"
+
+using namespace GAMM;
+
+static_assert(std::is_same_v<scalar_t, float>,
+              "Matrix files hold float32 entries");
+
+static constexpr size_t LEGACY_HEADER_SIZE = 2 * sizeof(uint64_t);
+
+MappedMatrix::MappedMatrix(Matrix matrix, std::optional<Vector> norms)
+    : owned{std::move(matrix)}, ownedNorms{std::move(norms)},
+      data{owned->data()}, rows{owned->rows()}, cols{owned->cols()},
+      norms{ownedNorms.has_value() ? ownedNorms->data() : nullptr} {}
+
+MappedMatrix::MappedMatrix(void *mapping, size_t mappingLength,
+                           const scalar_t *data, size_t rows, size_t cols,
+                           const scalar_t *norms)
+    : mapping{mapping}, mappingLength{mappingLength}, data{data},
+      rows(rows), cols(cols), norms{norms} {}
+
+MappedMatrix::~MappedMatrix() {
+  if (mapping != nullptr) {
+    munmap(mapping, mappingLength);
+  }
+}
+
+// Copies count entries of the given dtype into a vector of scalar_t
+template <typename T>
+static void convert(const char *src, scalar_t *dst, size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    T value;
+    std::memcpy(&value, src + i * sizeof(T), sizeof(T));
+    dst[i] = (scalar_t)value;
+  }
+}
+
+// Calls f(start, length) on ranges covering [0, n), one for each thread of pool
+// and one on the calling thread
+template <typename F>
+static void parallelRanges(size_t n, BS::thread_pool *pool, const F &f) {
+  size_t nchunks = 1;
+  if (pool != nullptr) {
+    nchunks =
+        std::max<size_t>(std::min<size_t>(pool->get_thread_count() + 1, n), 1);
+  }
+
+  auto runChunk = [&f, n, nchunks](size_t chunk) {
+    auto [start, length] = UtilityFunctions::unevenDivide(chunk, n, nchunks);
+    f(start, length);
+  };
+
+  BS::multi_future<void> tasks(nchunks - 1);
+  for (size_t i = 1; i < nchunks; ++i) {
+    tasks[i - 1] = pool->submit([&runChunk, i]() { runChunk(i); });
+  }
+  runChunk(0);
+  tasks.wait();
+}
+
+typedef Eigen::Matrix<scalar_t, Eigen::Dynamic, Eigen::Dynamic,
+                      Eigen::RowMajor>
+    RowMajorMatrix;
+
+static void convert(GmatHeader::DType dtype, const char *src, scalar_t *dst,
+                    size_t count) {
+  if (dtype == GmatHeader::DType::Float64) {
+    convert<double>(src, dst, count);
+  } else {
+    convert<float>(src, dst, count);
+  }
+}
+
+// Converts a payload of any dtype and layout into memory. Row-major payloads
+// are split into ranges of rows and column-major ones into ranges of columns,
+// so that each range is a contiguous part of the file
+static Matrix convertPayload(const char *payload,
+                             const MatrixFile::Description &description,
+                             BS::thread_pool *pool) {
+  auto rows = description.rows, cols = description.cols;
+  auto dtypeSize = description.dtypeSize();
+  Matrix matrix(rows, cols);
+
+  if (description.layout == GmatHeader::Layout::ColumnMajor) {
+    parallelRanges(cols, pool, [&](size_t start, size_t n) {
+      convert(description.dtype, payload + start * rows * dtypeSize,
+              matrix.data() + start * rows, n * rows);
+    });
+  } else if (description.dtype == GmatHeader::DType::Float32) {
+    // Transposing straight from the mapping is far faster than reading the
+    // entries one at a time
+    parallelRanges(rows, pool, [&](size_t start, size_t n) {
+      matrix.middleRows(start, n) = Eigen::Map<const RowMajorMatrix>(
+          reinterpret_cast<const scalar_t *>(payload) + start * cols, n, cols);
+    });
+  } else {
+    parallelRanges(rows, pool, [&](size_t start, size_t n) {
+      RowMajorMatrix block(n, cols);
+      convert(description.dtype, payload + start * cols * dtypeSize,
+              block.data(), block.size());
+      matrix.middleRows(start, n) = block;
+    });
+  }
+
+  return matrix;
+}
+
+std::optional<MappedMatrixPtr>
+MappedMatrix::openGmat(const std::string &path, void *mapping, size_t length,
+                       bool verify, BS::thread_pool *pool) {
+  GmatHeader header;
+  std::memcpy(&header, mapping, sizeof(header));
+  auto base = static_cast<const char *>(mapping);
+
+  auto fail = [&](auto message) -> std::optional<MappedMatrixPtr> {
+    INTELLI_WARNING(path << ": " << message);
+    munmap(mapping, length);
+    return {};
+  };
+
+  if (header.version != GmatHeader::VERSION) {
+    return fail("unsupported version " + std::to_string(header.version));
+  }
+  if (header.dtype != GmatHeader::DType::Float32 &&
+      header.dtype != GmatHeader::DType::Float64) {
+    return fail("unknown dtype");
+  }
+  if (header.layout != GmatHeader::Layout::ColumnMajor &&
+      header.layout != GmatHeader::Layout::RowMajor) {
+    return fail("unknown layout");
+  }
+
+  size_t count = header.rows * header.cols;
+  size_t payloadSize = count * header.dtypeSize();
+  size_t normsSize = header.hasColumnNorms ? header.cols * header.dtypeSize()
+                                           : 0;
+  if (header.payloadOffset % GmatHeader::ALIGNMENT != 0 ||
+      header.payloadOffset + payloadSize > length ||
+      (header.hasColumnNorms && header.normsOffset + normsSize > length)) {
+    return fail("truncated or corrupt header");
+  }
+
+  auto payload = base + header.payloadOffset;
+  auto normsData = header.hasColumnNorms ? base + header.normsOffset : nullptr;
+
+  if (verify) {
+    auto sum = MatrixFile::checksum(payload, payloadSize);
+    if (header.hasColumnNorms) {
+      sum = MatrixFile::checksum(normsData, normsSize, sum);
+    }
+    if (sum != header.checksum) {
+      return fail("checksum mismatch");
+    }
+  }
+
+  if (header.dtype == GmatHeader::DType::Float32 &&
+      header.layout == GmatHeader::Layout::ColumnMajor) {
+    madvise(mapping, length, MADV_WILLNEED);
+    return MappedMatrixPtr{new MappedMatrix(
+        mapping, length, reinterpret_cast<const scalar_t *>(payload),
+        header.rows, header.cols,
+        reinterpret_cast<const scalar_t *>(normsData))};
+  }
+
+  // Anything else is converted into memory
+  madvise(mapping, length, MADV_SEQUENTIAL);
+  Matrix matrix = convertPayload(
+      payload,
+      {header.rows, header.cols, header.payloadOffset, header.dtype,
+       header.layout},
+      pool);
+
+  std::optional<Vector> norms;
+  if (header.hasColumnNorms) {
+    norms.emplace(header.cols);
+    convert(header.dtype, normsData, norms->data(), header.cols);
+  }
+  munmap(mapping, length);
+
+  return std::make_shared<const MappedMatrix>(std::move(matrix),
+                                              std::move(norms));
+}
+
+std::optional<MappedMatrixPtr>
+MappedMatrix::openNpy(const std::string &path, void *mapping, size_t length,
+                      BS::thread_pool *pool) {
+  auto base = static_cast<const char *>(mapping);
+  auto description = MatrixFile::describeNpy(base, length, path);
+  if (!description.has_value()) {
+    munmap(mapping, length);
+    return {};
+  }
+
+  auto [rows, cols, payloadOffset, dtype, layout] = description.value();
+  if (payloadOffset + rows * cols * description->dtypeSize() > length) {
+    INTELLI_WARNING(path << " is truncated, expected a (" << rows << ", "
+                         << cols << ") matrix");
+    munmap(mapping, length);
+    return {};
+  }
+
+  // Fortran order is column-major, and so is any vector. NumPy aligns the
+  // payload, so the mapping can be used in place
+  auto payload = base + payloadOffset;
+  if (dtype == GmatHeader::DType::Float32 &&
+      (layout == GmatHeader::Layout::ColumnMajor || rows == 1 || cols == 1) &&
+      payloadOffset % alignof(scalar_t) == 0) {
+    madvise(mapping, length, MADV_WILLNEED);
+    return MappedMatrixPtr{
+        new MappedMatrix(mapping, length,
+                         reinterpret_cast<const scalar_t *>(payload), rows,
+                         cols)};
+  }
+
+  madvise(mapping, length, MADV_SEQUENTIAL);
+  Matrix matrix = convertPayload(payload, description.value(), pool);
+  munmap(mapping, length);
+
+  return std::make_shared<const MappedMatrix>(std::move(matrix));
+}
+
+std::optional<MappedMatrixPtr>
+MappedMatrix::open(const std::string &path, bool verify,
+                   BS::thread_pool *pool) {
+  auto fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    INTELLI_WARNING("Cannot open " << path << ": " << std::strerror(errno));
+    return {};
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || (size_t)st.st_size < LEGACY_HEADER_SIZE) {
+    INTELLI_WARNING(path << " is too small to be a matrix file");
+    close(fd);
+    return {};
+  }
+
+  size_t length = st.st_size;
+  auto mapping = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  // The mapping keeps the file alive
+  close(fd);
+
+  if (mapping == MAP_FAILED) {
+    INTELLI_WARNING("Cannot map " << path << ": " << std::strerror(errno));
+    return {};
+  }
+
+  if (length >= sizeof(GmatHeader) &&
+      std::memcmp(mapping, GmatHeader::MAGIC, sizeof(GmatHeader::MAGIC)) == 0) {
+    return openGmat(path, mapping, length, verify, pool);
+  }
+  if (length >= sizeof(MatrixFile::NPY_MAGIC) &&
+      std::memcmp(mapping, MatrixFile::NPY_MAGIC,
+                  sizeof(MatrixFile::NPY_MAGIC)) == 0) {
+    return openNpy(path, mapping, length, pool);
+  }
+  if (length >= sizeof(MatrixFile::MATRIX_MARKET_MAGIC) &&
+      std::memcmp(mapping, MatrixFile::MATRIX_MARKET_MAGIC,
+                  sizeof(MatrixFile::MATRIX_MARKET_MAGIC)) == 0) {
+    madvise(mapping, length, MADV_SEQUENTIAL);
+    auto matrix = MatrixMarket::parse(
+        std::string_view{static_cast<const char *>(mapping), length}, path);
+    munmap(mapping, length);
+    if (!matrix.has_value()) {
+      return {};
+    }
+    return std::make_shared<const MappedMatrix>(std::move(matrix.value()));
+  }
+
+  uint64_t header[2];
+  std::memcpy(header, mapping, LEGACY_HEADER_SIZE);
+  auto [rows, cols] = header;
+  auto payload = reinterpret_cast<const scalar_t *>(
+      (const char *)mapping + LEGACY_HEADER_SIZE);
+
+  if ((length - LEGACY_HEADER_SIZE) / sizeof(scalar_t) /
+          std::max<uint64_t>(rows, 1) <
+      cols) {
+    INTELLI_WARNING(path << " is truncated, expected a (" << rows << ", "
+                         << cols << ") matrix");
+    munmap(mapping, length);
+    return {};
+  }
+
+  auto isColumnMajor = path.ends_with(".cdat");
+  if (isColumnMajor) {
+    madvise(mapping, length, MADV_WILLNEED);
+    return MappedMatrixPtr{
+        new MappedMatrix(mapping, length, payload, rows, cols)};
+  }
+
+  // Row-major files have to be transposed
+  madvise(mapping, length, MADV_SEQUENTIAL);
+  Matrix matrix = convertPayload(
+      reinterpret_cast<const char *>(payload),
+      {rows, cols, LEGACY_HEADER_SIZE, GmatHeader::DType::Float32,
+       GmatHeader::Layout::RowMajor},
+      pool);
+  munmap(mapping, length);
+
+  return std::make_shared<const MappedMatrix>(std::move(matrix));
+}
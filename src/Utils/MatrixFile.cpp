@@ -0,0 +1,355 @@
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <vector>
+
+#include "Utils/Logger.hpp"
+#include "Utils/MatrixFile.hpp"
+
+using namespace GAMM;
+
+static size_t alignUp(size_t offset) {
+  return (offset + GmatHeader::ALIGNMENT - 1) / GmatHeader::ALIGNMENT *
+         GmatHeader::ALIGNMENT;
+}
+
+std::optional<MatrixFile::Description>
+MatrixFile::describe(const std::string &path) {
+  std::ifstream f(path, std::ios::in | std::ios::binary);
+  std::error_code ec;
+  auto length = std::filesystem::file_size(path, ec);
+  if (!f || ec) {
+    INTELLI_WARNING("Cannot open " << path);
+    return {};
+  }
+
+  GmatHeader header{};
+  f.read(reinterpret_cast<char *>(&header), sizeof(header));
+  auto startsWith = [&](const auto &magic) {
+    return (size_t)f.gcount() >= sizeof(magic) &&
+           std::memcmp(&header, magic, sizeof(magic)) == 0;
+  };
+
+  Description description;
+  if (startsWith(NPY_MAGIC)) {
+    // Version 1 headers are at most 64KiB, anything longer is unexpected
+    std::vector<char> buffer(std::min<size_t>(length, (1 << 16) + 16));
+    f.clear();
+    f.seekg(0);
+    f.read(buffer.data(), buffer.size());
+    auto npy = describeNpy(buffer.data(), f.gcount(), path);
+    if (!npy.has_value()) {
+      return {};
+    }
+    description = npy.value();
+  } else if (startsWith(MATRIX_MARKET_MAGIC)) {
+    INTELLI_WARNING(path << " is a Matrix Market file, which cannot be read "
+                            "in blocks. Convert it with gmat-convert first");
+    return {};
+  } else if (f.gcount() == sizeof(header) &&
+      std::memcmp(header.magic, GmatHeader::MAGIC, sizeof(header.magic)) == 0) {
+    if (header.version != GmatHeader::VERSION) {
+      INTELLI_WARNING(path << ": unsupported version " << header.version);
+      return {};
+    }
+    description = {header.rows, header.cols, header.payloadOffset,
+                   header.dtype, header.layout};
+  } else {
+    // The legacy formats only have the number of rows and columns
+    uint64_t legacy[2];
+    if (f.gcount() < (std::streamsize)sizeof(legacy)) {
+      INTELLI_WARNING(path << " is too small to be a matrix file");
+      return {};
+    }
+    std::memcpy(legacy, &header, sizeof(legacy));
+    auto isColumnMajor = path.ends_with(".cdat");
+    description = {legacy[0], legacy[1], sizeof(legacy),
+                   GmatHeader::DType::Float32,
+                   isColumnMajor ? GmatHeader::Layout::ColumnMajor
+                                 : GmatHeader::Layout::RowMajor};
+  }
+
+  if (description.payloadOffset +
+          description.rows * description.cols * description.dtypeSize() >
+      length) {
+    INTELLI_WARNING(path << " is truncated, expected a (" << description.rows
+                         << ", " << description.cols << ") matrix");
+    return {};
+  }
+
+  return description;
+}
+
+std::optional<MatrixFile::Description>
+MatrixFile::describeNpy(const char *data, size_t length,
+                        const std::string &path) {
+  auto fail = [&](auto message) -> std::optional<Description> {
+    INTELLI_WARNING(path << ": " << message);
+    return {};
+  };
+
+  // The magic is followed by the major and minor version, then the length of
+  // the header as a 16-bit integer in version 1 and a 32-bit one after that
+  constexpr size_t preamble = sizeof(NPY_MAGIC) + 2;
+  if (length < preamble + sizeof(uint16_t) ||
+      std::memcmp(data, NPY_MAGIC, sizeof(NPY_MAGIC)) != 0) {
+    return fail("not a .npy file");
+  }
+
+  size_t headerStart, headerLength;
+  auto major = (uint8_t)data[sizeof(NPY_MAGIC)];
+  if (major == 1) {
+    uint16_t n;
+    std::memcpy(&n, data + preamble, sizeof(n));
+    headerStart = preamble + sizeof(n);
+    headerLength = n;
+  } else if ((major == 2 || major == 3) &&
+             length >= preamble + sizeof(uint32_t)) {
+    uint32_t n;
+    std::memcpy(&n, data + preamble, sizeof(n));
+    headerStart = preamble + sizeof(n);
+    headerLength = n;
+  } else {
+    return fail("unsupported .npy version " + std::to_string(major));
+  }
+  if (headerStart + headerLength > length) {
+    return fail("truncated .npy header");
+  }
+
+  // The header is a Python dict literal such as
+  // {'descr': '<f4', 'fortran_order': False, 'shape': (3, 4), }
+  std::string_view dict(data + headerStart, headerLength);
+  auto value = [&](std::string_view key) -> std::optional<std::string_view> {
+    auto pos = dict.find(key);
+    if (pos == std::string_view::npos) {
+      return {};
+    }
+    pos = dict.find(':', pos + key.size());
+    if (pos == std::string_view::npos) {
+      return {};
+    }
+    pos = dict.find_first_not_of(' ', pos + 1);
+    if (pos == std::string_view::npos) {
+      return {};
+    }
+    return dict.substr(pos);
+  };
+
+  auto descr = value("'descr'");
+  auto fortranOrder = value("'fortran_order'");
+  auto shape = value("'shape'");
+  if (!descr.has_value() || !fortranOrder.has_value() || !shape.has_value()) {
+    return fail("malformed .npy header");
+  }
+
+  Description description{};
+  description.payloadOffset = headerStart + headerLength;
+
+  if (descr->starts_with("'<f4'")) {
+    description.dtype = GmatHeader::DType::Float32;
+  } else if (descr->starts_with("'<f8'")) {
+    description.dtype = GmatHeader::DType::Float64;
+  } else {
+    return fail("unsupported dtype " +
+                std::string{descr->substr(0, descr->find(','))});
+  }
+
+  description.layout = fortranOrder->starts_with("True")
+                           ? GmatHeader::Layout::ColumnMajor
+                           : GmatHeader::Layout::RowMajor;
+
+  auto close = shape->find(')');
+  if (!shape->starts_with('(') || close == std::string_view::npos) {
+    return fail("malformed .npy shape");
+  }
+  std::vector<size_t> dims;
+  auto dimsText = shape->substr(1, close - 1);
+  while (true) {
+    auto pos = dimsText.find_first_not_of(", ");
+    if (pos == std::string_view::npos) {
+      break;
+    }
+    dimsText.remove_prefix(pos);
+    size_t dim;
+    auto [end, ec] =
+        std::from_chars(dimsText.data(), dimsText.data() + dimsText.size(), dim);
+    if (ec != std::errc{}) {
+      return fail("malformed .npy shape");
+    }
+    dims.push_back(dim);
+    dimsText.remove_prefix(end - dimsText.data());
+  }
+
+  if (dims.size() == 1) {
+    description.rows = dims[0];
+    description.cols = 1;
+  } else if (dims.size() == 2) {
+    description.rows = dims[0];
+    description.cols = dims[1];
+  } else {
+    return fail("only 1-D and 2-D arrays are supported, got " +
+                std::to_string(dims.size()) + " dimensions");
+  }
+
+  return description;
+}
+
+uint64_t MatrixFile::checksum(const void *data, size_t size,
+                              uint64_t hash) noexcept {
+  constexpr uint64_t prime = 0x100000001b3ULL;
+  auto bytes = static_cast<const char *>(data);
+
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, bytes + i, sizeof(word));
+    hash = (hash ^ word) * prime;
+  }
+  if (i < size) {
+    uint64_t word = 0;
+    std::memcpy(&word, bytes + i, size - i);
+    hash = (hash ^ word) * prime;
+  }
+
+  return hash;
+}
+
+bool MatrixFile::writeGmat(const std::string &path, MatrixRef matrix,
+                           bool columnNorms) {
+  // The checksum is over the payload as it is laid out in the file
+  const Matrix contiguous =
+      (matrix.outerStride() == matrix.rows()) ? Matrix{} : Matrix{matrix};
+  const scalar_t *payload = (matrix.outerStride() == matrix.rows())
+                                ? matrix.data()
+                                : contiguous.data();
+  size_t payloadSize = matrix.size() * sizeof(scalar_t);
+
+  Vector norms;
+  if (columnNorms) {
+    norms = matrix.colwise().norm().transpose();
+  }
+
+  GmatHeader header{};
+  std::memcpy(header.magic, GmatHeader::MAGIC, sizeof(header.magic));
+  header.version = GmatHeader::VERSION;
+  header.dtype = GmatHeader::DType::Float32;
+  header.layout = GmatHeader::Layout::ColumnMajor;
+  header.hasColumnNorms = columnNorms;
+  header.rows = matrix.rows();
+  header.cols = matrix.cols();
+  header.payloadOffset = alignUp(sizeof(header));
+  header.normsOffset =
+      columnNorms ? alignUp(header.payloadOffset + payloadSize) : 0;
+  header.checksum = checksum(payload, payloadSize);
+  if (columnNorms) {
+    header.checksum = checksum(norms.data(), norms.size() * sizeof(scalar_t),
+                               header.checksum);
+  }
+
+  std::ofstream f(path, std::ios::out | std::ios::binary | std::ios::trunc);
+  const char zeros[GmatHeader::ALIGNMENT] = {};
+
+  f.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  f.write(zeros, header.payloadOffset - sizeof(header));
+  f.write(reinterpret_cast<const char *>(payload), payloadSize);
+  if (columnNorms) {
+    f.write(zeros, header.normsOffset - header.payloadOffset - payloadSize);
+    f.write(reinterpret_cast<const char *>(norms.data()),
+            norms.size() * sizeof(scalar_t));
+  }
+  f.close();
+
+  if (f.fail()) {
+    INTELLI_WARNING("Failed to write " << path);
+    return false;
+  }
+  return true;
+}
+
+bool MatrixFile::writeGmatProduct(const std::string &path, MatrixRef a,
+                                  MatrixRef b, size_t tileCols,
+                                  BS::thread_pool *pool, bool columnNorms) {
+  size_t rows = a.rows(), cols = b.rows();
+  size_t payloadSize = rows * cols * sizeof(scalar_t);
+
+  // The checksum is continued from one tile to the next, which only gives the
+  // checksum of the whole payload if every tile but the last is a whole
+  // number of 64-bit words
+  tileCols = std::max<size_t>(tileCols, 1);
+  if (rows % 2 == 1 && tileCols % 2 == 1) {
+    ++tileCols;
+  }
+
+  GmatHeader header{};
+  std::memcpy(header.magic, GmatHeader::MAGIC, sizeof(header.magic));
+  header.version = GmatHeader::VERSION;
+  header.dtype = GmatHeader::DType::Float32;
+  header.layout = GmatHeader::Layout::ColumnMajor;
+  header.hasColumnNorms = columnNorms;
+  header.rows = rows;
+  header.cols = cols;
+  header.payloadOffset = alignUp(sizeof(header));
+  header.normsOffset =
+      columnNorms ? alignUp(header.payloadOffset + payloadSize) : 0;
+
+  std::ofstream f(path, std::ios::out | std::ios::binary | std::ios::trunc);
+  const char zeros[GmatHeader::ALIGNMENT] = {};
+
+  // The header is written again once the checksum is known
+  f.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  f.write(zeros, header.payloadOffset - sizeof(header));
+
+  auto ntiles = (cols + tileCols - 1) / tileCols;
+  size_t wave = pool == nullptr ? 1 : pool->get_thread_count() + 1;
+  std::vector<Matrix> tiles(std::min(wave, ntiles));
+  Vector norms(columnNorms ? cols : 0);
+  auto checksum = MatrixFile::checksum(nullptr, 0);
+
+  for (size_t first = 0; first < ntiles && f; first += wave) {
+    auto n = std::min(wave, ntiles - first);
+
+    auto computeTile = [&](size_t i) {
+      auto start = (first + i) * tileCols;
+      auto width = std::min(tileCols, cols - start);
+      tiles[i].noalias() = a * b.middleRows(start, width).transpose();
+      if (columnNorms) {
+        norms.segment(start, width) = tiles[i].colwise().norm().transpose();
+      }
+    };
+
+    BS::multi_future<void> tasks(n - 1);
+    for (size_t i = 1; i < n; ++i) {
+      tasks[i - 1] = pool->submit([&computeTile, i]() { computeTile(i); });
+    }
+    computeTile(0);
+    tasks.wait();
+
+    for (size_t i = 0; i < n; ++i) {
+      auto size = tiles[i].size() * sizeof(scalar_t);
+      f.write(reinterpret_cast<const char *>(tiles[i].data()), size);
+      checksum = MatrixFile::checksum(tiles[i].data(), size, checksum);
+    }
+  }
+
+  if (columnNorms) {
+    f.write(zeros, header.normsOffset - header.payloadOffset - payloadSize);
+    f.write(reinterpret_cast<const char *>(norms.data()),
+            norms.size() * sizeof(scalar_t));
+    checksum = MatrixFile::checksum(norms.data(),
+                                    norms.size() * sizeof(scalar_t), checksum);
+  }
+
+  header.checksum = checksum;
+  f.seekp(0);
+  f.write(reinterpret_cast<const char *>(&header), sizeof(header));
+  f.close();
+
+  if (f.fail()) {
+    INTELLI_WARNING("Failed to write " << path);
+    return false;
+  }
+  return true;
+}
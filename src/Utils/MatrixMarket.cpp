@@ -0,0 +1,147 @@
+#include <cctype>
+#include <charconv>
+#include <sstream>
+#include <vector>
+
+#include "Utils/Logger.hpp"
+#include "Utils/MatrixMarket.hpp"
+
+using namespace GAMM;
+
+namespace {
+// Reads the whitespace separated numbers of a file, skipping comment lines
+class Tokenizer {
+public:
+  explicit Tokenizer(std::string_view text) : text{text} {}
+
+  template <typename T> std::optional<T> next() {
+    skip();
+    T value;
+    auto [end, ec] =
+        std::from_chars(text.data(), text.data() + text.size(), value);
+    if (ec != std::errc{}) {
+      return {};
+    }
+    text.remove_prefix(end - text.data());
+    return value;
+  }
+
+private:
+  void skip() {
+    while (!text.empty()) {
+      if (std::isspace((unsigned char)text.front())) {
+        text.remove_prefix(1);
+      } else if (text.front() == '%') {
+        auto eol = text.find('\n');
+        text.remove_prefix(eol == std::string_view::npos ? text.size()
+                                                         : eol + 1);
+      } else {
+        break;
+      }
+    }
+  }
+
+  std::string_view text;
+};
+} // namespace
+
+std::optional<Matrix> MatrixMarket::parse(std::string_view text,
+                                          const std::string &path) {
+  auto fail = [&](auto message) -> std::optional<Matrix> {
+    INTELLI_WARNING(path << ": " << message);
+    return {};
+  };
+
+  // %%MatrixMarket matrix <format> <field> <symmetry>, case insensitive
+  auto eol = text.find('\n');
+  std::string banner{text.substr(0, eol)};
+  for (auto &c : banner) {
+    c = std::tolower((unsigned char)c);
+  }
+  std::istringstream words{banner};
+  std::string magic, object, format, field, symmetry;
+  words >> magic >> object >> format >> field >> symmetry;
+
+  if (magic != "%%matrixmarket" || object != "matrix") {
+    return fail("not a Matrix Market matrix");
+  }
+  if (format != "array" && format != "coordinate") {
+    return fail("unknown format " + format);
+  }
+  if (field != "real" && field != "double" && field != "integer" &&
+      field != "pattern") {
+    return fail("unsupported field " + field);
+  }
+  if (symmetry != "general" && symmetry != "symmetric" &&
+      symmetry != "skew-symmetric") {
+    return fail("unsupported symmetry " + symmetry);
+  }
+  bool isPattern = field == "pattern";
+  bool isGeneral = symmetry == "general";
+  scalar_t mirror = symmetry == "skew-symmetric" ? -1 : 1;
+
+  Tokenizer tokens{text.substr(eol == std::string_view::npos ? text.size()
+                                                             : eol + 1)};
+  auto rows = tokens.next<size_t>();
+  auto cols = tokens.next<size_t>();
+  if (!rows.has_value() || !cols.has_value()) {
+    return fail("missing matrix size");
+  }
+  if (!isGeneral && rows.value() != cols.value()) {
+    return fail("a " + symmetry + " matrix must be square");
+  }
+
+  Matrix matrix = Matrix::Zero(rows.value(), cols.value());
+
+  if (format == "array") {
+    if (isPattern) {
+      return fail("array files cannot hold pattern entries");
+    }
+    // Columns in order, only the lower triangle if the matrix is symmetric
+    // and without the diagonal if it is skew-symmetric
+    for (size_t j = 0; j < cols.value(); ++j) {
+      size_t first = isGeneral ? 0 : (mirror < 0 ? j + 1 : j);
+      for (size_t i = first; i < rows.value(); ++i) {
+        auto value = tokens.next<double>();
+        if (!value.has_value()) {
+          return fail("expected " + std::to_string(rows.value()) + "x" +
+                      std::to_string(cols.value()) + " entries");
+        }
+        matrix(i, j) = (scalar_t)value.value();
+        if (!isGeneral && i != j) {
+          matrix(j, i) = mirror * (scalar_t)value.value();
+        }
+      }
+    }
+    return matrix;
+  }
+
+  auto entries = tokens.next<size_t>();
+  if (!entries.has_value()) {
+    return fail("missing number of entries");
+  }
+
+  for (size_t k = 0; k < entries.value(); ++k) {
+    auto i = tokens.next<size_t>();
+    auto j = tokens.next<size_t>();
+    auto value = isPattern ? std::optional<double>{1.0} : tokens.next<double>();
+    if (!i.has_value() || !j.has_value() || !value.has_value()) {
+      return fail("expected " + std::to_string(entries.value()) +
+                  " entries, entry " + std::to_string(k + 1) +
+                  " is malformed");
+    }
+    // Coordinates are 1-based
+    if (i.value() == 0 || j.value() == 0 || i.value() > rows.value() ||
+        j.value() > cols.value()) {
+      return fail("entry " + std::to_string(k + 1) + " is out of bounds");
+    }
+
+    auto r = i.value() - 1, c = j.value() - 1;
+    matrix(r, c) += (scalar_t)value.value();
+    if (!isGeneral && r != c) {
+      matrix(c, r) += mirror * (scalar_t)value.value();
+    }
+  }
+
+  return matrix;
+}
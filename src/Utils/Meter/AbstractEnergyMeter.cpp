@@ -8,6 +8,9 @@ using namespace GAMM;
 
 double AbstractEnergyMeter::Readings::energyConsumed() const noexcept {
   assert(current.size() == voltage.size());
+  if (!cumulativeJ.empty()) {
+    return cumulativeJ.back();
+  }
   double cumulative_energy{};
   for (auto i = std::begin(current), v = std::begin(voltage);
        i != std::end(current); ++i, ++v) {
@@ -29,15 +32,29 @@ void AbstractEnergyMeter::Readings::writeCSV(const char *path) const {
   double cumulative_energy{};
 
   f << "Time (ms), Voltage (mV), Current (mA), Power (W),"
-       "Cumulative Energy (J)\n";
+       "Cumulative Energy (J)";
+  for (const auto &column : columns) {
+    assert(column.cumulativeJ.size() == current.size());
+    f << ", " << column.name << " (J)";
+  }
+  f << "\n";
 
   for (size_t i = 0; i != current.size(); ++i) {
-    size_t time_ms = i * samplingInterval.count();
+    double time_ms = timeNs.empty() ? double(i * samplingInterval.count())
+                                    : double(timeNs[i]) / 1e6;
     auto v = voltage[i];
     auto c = current[i];
-    auto power = (double)(v * c) / 1e6;
-    cumulative_energy += power * (double)samplingInterval.count() / 1e3;
+    auto power = (double)v * c / 1e6;
+    if (cumulativeJ.empty()) {
+      cumulative_energy += power * (double)samplingInterval.count() / 1e3;
+    } else {
+      cumulative_energy = cumulativeJ[i];
+    }
     f << time_ms << ", " << v << ", " << c << ", " << power << ", "
-      << cumulative_energy << std::endl;
+      << cumulative_energy;
+    for (const auto &column : columns) {
+      f << ", " << column.cumulativeJ[i];
+    }
+    f << "\n";
   }
 }
@@ -0,0 +1,96 @@
+#include <algorithm>
+
+#include "Utils/Meter/EnergySampler.hpp"
+
+using namespace GAMM;
+
+EnergySampler::EnergySampler(AbstractEnergyMeter::Duration interval,
+                             Source source, size_t capacity)
+    : interval{interval}, source{std::move(source)},
+      ring(std::max<size_t>(capacity, 1)) {}
+
+void EnergySampler::start() {
+  if (thread.has_value()) {
+    return;
+  }
+  nsamples = 0;
+  shouldStop.store(false, std::memory_order_relaxed);
+  started = Clock::now();
+  thread.emplace([this]() { run(); });
+}
+
+void EnergySampler::run() {
+  auto deadline = started;
+  std::optional<Sample> previous{};
+
+  // One more sample is taken once asked to stop, so that the samples cover
+  // the whole run
+  for (bool last = false; !last;) {
+    last = shouldStop.load(std::memory_order_relaxed);
+
+    auto measurement = source();
+    auto now = Clock::now();
+    if (measurement.has_value()) {
+      Sample sample{uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                 now - started)
+                                 .count()),
+                    measurement->voltage, measurement->current, 0};
+
+      if (previous.has_value()) {
+        double energyJ;
+        if (measurement->energyJ.has_value()) {
+          energyJ = measurement->energyJ.value();
+        } else {
+          // mV * mA = uW
+          double powerW = (double(previous->voltage) * previous->current +
+                           double(sample.voltage) * sample.current) /
+                          2e6;
+          energyJ = powerW * (sample.timeNs - previous->timeNs) / 1e9;
+        }
+        sample.cumulativeJ = previous->cumulativeJ + energyJ;
+      } else if (measurement->energyJ.has_value()) {
+        // Counted from before start(), so it belongs to the run
+        sample.cumulativeJ = measurement->energyJ.value();
+      }
+
+      ring[nsamples++ % ring.size()] = sample;
+      previous = sample;
+    }
+
+    // Deadlines missed because a read was slow are skipped rather than
+    // caught up with
+    deadline += interval;
+    if (deadline <= now) {
+      deadline = now + interval;
+    }
+    if (!last) {
+      std::this_thread::sleep_until(deadline);
+    }
+  }
+}
+
+AbstractEnergyMeter::Readings EnergySampler::stop() {
+  AbstractEnergyMeter::Readings readings{interval};
+  if (!thread.has_value()) {
+    return readings;
+  }
+  shouldStop.store(true, std::memory_order_relaxed);
+  thread->join();
+  thread.reset();
+
+  readings.startTime = started;
+  auto n = std::min(nsamples, ring.size());
+  readings.timeNs.reserve(n);
+  readings.voltage.reserve(n);
+  readings.current.reserve(n);
+  readings.cumulativeJ.reserve(n);
+  for (auto i = nsamples - n; i < nsamples; ++i) {
+    const auto &sample = ring[i % ring.size()];
+    readings.timeNs.push_back(sample.timeNs);
+    readings.voltage.push_back(sample.voltage);
+    readings.current.push_back(sample.current);
+    readings.cumulativeJ.push_back(sample.cumulativeJ);
+  }
+
+  return readings;
+}
@@ -1,9 +1,10 @@
 #include <Utils/Meter/JetsonEnergyMeter.hpp>
-#include <atomic>
+#include <charconv>
 #include <cstdint>
 #include <fcntl.h>
 #include <filesystem>
 #include <memory>
+#include <unistd.h>
 
 using namespace GAMM;
 
@@ -22,7 +23,7 @@ void JetsonEnergyMeter::init() {
   voltageFd = open(voltagePath.c_str(), O_RDONLY);
 
   auto currentPath = entry.path() / "curr2_input";
-  if (!std::filesystem::exists(voltagePath)) {
+  if (!std::filesystem::exists(currentPath)) {
     throw "Unable to open current file";
   };
   currentFd = open(currentPath.c_str(), O_RDONLY);
@@ -32,52 +33,40 @@ bool JetsonEnergyMeter::canBeUsed() {
   return std::filesystem::is_directory(SYS_BASE);
 }
 
-uint32_t read(int fd) {
-  char buff[256];
-  int nread;
-  nread = read(fd, buff, 256);
-  buff[nread] = 0;
-  double ru = std::atof(buff);
-  // printf("%s\r\n",buff);
-  return ru;
+JetsonEnergyMeter::~JetsonEnergyMeter() {
+  stopSampling();
+  close(voltageFd);
+  close(currentFd);
 }
 
-void JetsonEnergyMeter::collectData(
-    std::shared_ptr<std::atomic_bool> shouldStop, JetsonEnergyMeter *meter) {
-  auto samplingInterval = meter->samplingInterval;
-  auto voltageFd = meter->voltageFd;
-  auto currentFd = meter->currentFd;
-
-  JetsonEnergyMeter::Readings readings{samplingInterval};
-
-  while (!shouldStop->load(std::memory_order_relaxed)) {
-    auto voltageReading = read(voltageFd);
-    auto currentReading = read(currentFd);
-
-    readings.voltage.push_back(voltageReading);
-    readings.current.push_back(currentReading);
-
-    std::this_thread::sleep_for(samplingInterval);
+// sysfs regenerates an attribute on every read from offset 0, so pread reads
+// the current value without seeking back first
+static std::optional<uint32_t> readValue(int fd) {
+  char buff[32];
+  auto nread = pread(fd, buff, sizeof(buff), 0);
+  if (nread <= 0) {
+    return {};
   }
 
-  meter->readings = std::move(readings);
+  uint32_t value;
+  auto [end, ec] = std::from_chars(buff, buff + nread, value);
+  if (ec != std::errc{}) {
+    return {};
+  }
+  return value;
 }
 
-void JetsonEnergyMeter::startSampling() {
-  if (samplingThread.has_value()) {
-    return;
+std::optional<EnergySampler::Measurement> JetsonEnergyMeter::measure() {
+  auto voltage = readValue(voltageFd);
+  auto current = readValue(currentFd);
+  if (!voltage.has_value() || !current.has_value()) {
+    return {};
   }
-  shouldStop->store(false, std::memory_order_relaxed);
-  samplingThread.emplace(std::thread(collectData, shouldStop, this));
+  return EnergySampler::Measurement{voltage.value(), current.value()};
 }
 
-JetsonEnergyMeter::Readings JetsonEnergyMeter::stopSampling() {
-  if (!samplingThread.has_value()) {
-    return {samplingInterval};
-  }
-  shouldStop->store(true, std::memory_order_relaxed);
-  samplingThread.value().join();
-  samplingThread.reset();
+void JetsonEnergyMeter::startSampling() { sampler.start(); }
 
-  return readings;
+JetsonEnergyMeter::Readings JetsonEnergyMeter::stopSampling() {
+  return sampler.stop();
 }
@@ -0,0 +1,135 @@
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "Utils/Logger.hpp"
+#include "Utils/Meter/PerfCounterGroup.hpp"
+
+using namespace GAMM;
+
+static constexpr uint64_t CONFIGS[PerfCounterGroup::NEVENTS] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES,
+};
+
+const char *PerfCounterGroup::name(Event event) noexcept {
+  static constexpr const char *NAMES[NEVENTS] = {
+      "cycles", "instructions", "cache-misses", "branch-misses"};
+  return NAMES[event];
+}
+
+static int openCounter(uint64_t config, pid_t tid) {
+  perf_event_attr attr;
+  std::memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = config;
+  attr.disabled = 1;
+  attr.inherit = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+  attr.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+  return syscall(SYS_perf_event_open, &attr, tid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+}
+
+std::optional<double> PerfCounterGroup::Counts::ipc() const noexcept {
+  if (!values[Cycles].has_value() || !values[Instructions].has_value() ||
+      values[Cycles].value() == 0) {
+    return {};
+  }
+  return double(values[Instructions].value()) / values[Cycles].value();
+}
+
+bool PerfCounterGroup::start() {
+  close();
+
+  std::vector<pid_t> tids;
+  std::error_code ec;
+  for (const auto &entry :
+       std::filesystem::directory_iterator{"/proc/self/task", ec}) {
+    tids.push_back(std::stoi(entry.path().filename().string()));
+  }
+  if (ec) {
+    INTELLI_WARNING("Cannot list the threads of the process: "
+                    << ec.message());
+    return false;
+  }
+
+  size_t nopened = 0;
+  for (size_t event = 0; event < NEVENTS; ++event) {
+    for (auto tid : tids) {
+      auto fd = openCounter(CONFIGS[event], tid);
+      if (fd < 0) {
+        // A thread may have exited since the listing, anything else means the
+        // event cannot be counted
+        if (errno == ESRCH) {
+          continue;
+        }
+        INTELLI_WARNING("Cannot count " << name(Event(event)) << ": "
+                                         << std::strerror(errno));
+        for (auto other : fds[event]) {
+          ::close(other);
+        }
+        fds[event].clear();
+        break;
+      }
+      fds[event].push_back(fd);
+    }
+    nopened += !fds[event].empty();
+  }
+
+  for (const auto &eventFds : fds) {
+    for (auto fd : eventFds) {
+      ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+      ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+  }
+
+  return nopened > 0;
+}
+
+PerfCounterGroup::Counts PerfCounterGroup::stop() {
+  Counts counts;
+
+  for (size_t event = 0; event < NEVENTS; ++event) {
+    if (fds[event].empty()) {
+      continue;
+    }
+
+    double total = 0;
+    for (auto fd : fds[event]) {
+      ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+
+      // value, time enabled, time running
+      uint64_t values[3];
+      if (read(fd, values, sizeof(values)) != sizeof(values) ||
+          values[2] == 0) {
+        continue;
+      }
+      total += double(values[0]) * values[1] / values[2];
+    }
+    counts.values[event] = uint64_t(total);
+  }
+
+  close();
+  return counts;
+}
+
+void PerfCounterGroup::close() noexcept {
+  for (auto &eventFds : fds) {
+    for (auto fd : eventFds) {
+      ::close(fd);
+    }
+    eventFds.clear();
+  }
+}
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <cassert>
+
+#include "Utils/Meter/PhaseEnergy.hpp"
+
+using namespace GAMM;
+
+void PhaseEnergy::attribute(AbstractEnergyMeter::Readings &readings,
+                            const std::vector<PhaseProfile::Marker> &markers) {
+  auto n = readings.cumulativeJ.size();
+  assert(readings.timeNs.size() == n);
+  if (markers.empty() || n < 2) {
+    return;
+  }
+
+  uint32_t nlevels = 0;
+  for (const auto &marker : markers) {
+    nlevels = std::max(nlevels, marker.level + 1);
+  }
+
+  std::vector<double> phaseJ(PhaseProfile::NPHASES), levelJ(nlevels);
+  double otherJ = 0;
+  std::vector<std::vector<double>> phaseColumns(PhaseProfile::NPHASES),
+      levelColumns(nlevels);
+  std::vector<double> otherColumn;
+  otherColumn.reserve(n);
+
+  auto at = [&](size_t i) {
+    return readings.startTime + std::chrono::nanoseconds(readings.timeNs[i]);
+  };
+
+  // The markers overlapping the current interval. Markers are sorted by
+  // start, and the intervals are visited in order, so each marker is added
+  // and removed once
+  std::vector<const PhaseProfile::Marker *> active;
+  size_t next = 0;
+  std::vector<double> overlaps;
+
+  for (size_t i = 0; i < n; ++i) {
+    if (i > 0) {
+      auto begin = at(i - 1), end = at(i);
+      auto energyJ = readings.cumulativeJ[i] - readings.cumulativeJ[i - 1];
+
+      for (; next < markers.size() && markers[next].start < end; ++next) {
+        active.push_back(&markers[next]);
+      }
+      std::erase_if(active, [&](auto marker) { return marker->end <= begin; });
+
+      overlaps.clear();
+      double busy = 0;
+      for (auto marker : active) {
+        auto overlap = std::chrono::duration<double>(
+                           std::min(marker->end, end) -
+                           std::max(marker->start, begin))
+                           .count();
+        overlaps.push_back(std::max(overlap, 0.0));
+        busy += overlaps.back();
+      }
+
+      double interval = std::chrono::duration<double>(end - begin).count();
+      double idle = std::max(interval - busy, 0.0);
+      double weight = busy + idle;
+      if (weight > 0) {
+        for (size_t j = 0; j < active.size(); ++j) {
+          auto share = energyJ * overlaps[j] / weight;
+          phaseJ[size_t(active[j]->phase)] += share;
+          levelJ[active[j]->level] += share;
+        }
+        otherJ += energyJ * idle / weight;
+      } else {
+        otherJ += energyJ;
+      }
+    }
+
+    for (size_t p = 0; p < PhaseProfile::NPHASES; ++p) {
+      phaseColumns[p].push_back(phaseJ[p]);
+    }
+    for (size_t level = 0; level < nlevels; ++level) {
+      levelColumns[level].push_back(levelJ[level]);
+    }
+    otherColumn.push_back(otherJ);
+  }
+
+  for (size_t p = 0; p < PhaseProfile::NPHASES; ++p) {
+    if (phaseJ[p] > 0) {
+      readings.columns.push_back(
+          {std::string{PhaseProfile::name(PhaseProfile::Phase(p))},
+           std::move(phaseColumns[p])});
+    }
+  }
+  readings.columns.push_back({"other", std::move(otherColumn)});
+  for (size_t level = 0; level < nlevels; ++level) {
+    readings.columns.push_back(
+        {"level " + std::to_string(level), std::move(levelColumns[level])});
+  }
+}
+
+std::vector<std::pair<std::string, double>>
+PhaseEnergy::totals(const AbstractEnergyMeter::Readings &readings) {
+  std::vector<std::pair<std::string, double>> ret;
+  for (const auto &column : readings.columns) {
+    ret.emplace_back(column.name, column.cumulativeJ.empty()
+                                      ? 0.0
+                                      : column.cumulativeJ.back());
+  }
+  return ret;
+}
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <charconv>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <unistd.h>
+
+#include "Utils/Logger.hpp"
+#include "Utils/Meter/RaplEnergyMeter.hpp"
+
+using namespace GAMM;
+
+static std::optional<uint64_t> readCounter(int fd) {
+  char buff[32];
+  auto nread = pread(fd, buff, sizeof(buff), 0);
+  if (nread <= 0) {
+    return {};
+  }
+
+  uint64_t value;
+  auto [end, ec] = std::from_chars(buff, buff + nread, value);
+  if (ec != std::errc{}) {
+    return {};
+  }
+  return value;
+}
+
+static std::string readLine(const std::filesystem::path &path) {
+  std::ifstream f{path};
+  std::string line;
+  std::getline(f, line);
+  return line;
+}
+
+std::vector<RaplEnergyMeter::Zone>
+RaplEnergyMeter::findZones(const std::string &basePath) {
+  std::vector<std::filesystem::path> paths;
+  std::error_code ec;
+  for (const auto &entry :
+       std::filesystem::directory_iterator{basePath, ec}) {
+    auto name = entry.path().filename().string();
+    // Packages are intel-rapl:N and their subzones intel-rapl:N:M, all of
+    // which are linked from basePath
+    if (!name.starts_with("intel-rapl:")) {
+      continue;
+    }
+    auto isSubzone = std::count(name.begin(), name.end(), ':') > 1;
+    auto zoneName = readLine(entry.path() / "name");
+    if (zoneName == "psys" || (isSubzone && zoneName != "dram")) {
+      continue;
+    }
+    paths.push_back(entry.path());
+  }
+  std::sort(paths.begin(), paths.end());
+
+  std::vector<Zone> zones;
+  for (const auto &path : paths) {
+    auto fd = open((path / "energy_uj").c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+      continue;
+    }
+
+    // energy_uj is only readable by root on recent kernels
+    auto current = readCounter(fd);
+    if (!current.has_value()) {
+      close(fd);
+      continue;
+    }
+
+    // Without the range a wrap of the counter cannot be accounted for
+    uint64_t maxEnergyUj = 0;
+    auto maxLine = readLine(path / "max_energy_range_uj");
+    auto [end, error] = std::from_chars(
+        maxLine.data(), maxLine.data() + maxLine.size(), maxEnergyUj);
+    if (error != std::errc{} || maxEnergyUj == 0) {
+      INTELLI_WARNING("Skipping RAPL zone " << path.filename().string()
+                                            << ", its energy range is unknown");
+      close(fd);
+      continue;
+    }
+
+    zones.push_back({path.filename().string() + " (" +
+                         readLine(path / "name") + ")",
+                     fd, maxEnergyUj, current.value()});
+  }
+
+  return zones;
+}
+
+RaplEnergyMeter::RaplEnergyMeter(Duration samplingInterval,
+                                 std::string basePath)
+    : AbstractEnergyMeter(samplingInterval), zones{findZones(basePath)},
+      sampler{samplingInterval, [this]() { return measure(); }} {
+  if (zones.empty()) {
+    throw "No readable RAPL zone";
+  }
+  for (const auto &zone : zones) {
+    INTELLI_INFO("Reading RAPL zone " << zone.name);
+  }
+}
+
+RaplEnergyMeter::~RaplEnergyMeter() {
+  stopSampling();
+  for (const auto &zone : zones) {
+    close(zone.fd);
+  }
+}
+
+bool RaplEnergyMeter::canBeUsed(const std::string &basePath) {
+  auto zones = findZones(basePath);
+  for (const auto &zone : zones) {
+    close(zone.fd);
+  }
+  return !zones.empty();
+}
+
+uint64_t RaplEnergyMeter::energyDeltaUj() {
+  uint64_t total = 0;
+  for (auto &zone : zones) {
+    auto current = readCounter(zone.fd);
+    if (!current.has_value()) {
+      continue;
+    }
+
+    if (current.value() >= zone.lastUj) {
+      total += current.value() - zone.lastUj;
+    } else {
+      // The counter wrapped around
+      total += zone.maxEnergyUj - zone.lastUj + current.value();
+    }
+    zone.lastUj = current.value();
+  }
+  return total;
+}
+
+std::optional<EnergySampler::Measurement> RaplEnergyMeter::measure() {
+  auto deltaUj = energyDeltaUj();
+  auto now = EnergySampler::Clock::now();
+  auto elapsedUs = std::chrono::duration_cast<std::chrono::microseconds>(
+                       now - lastMeasured)
+                       .count();
+  lastMeasured = now;
+
+  // P (mW) = E (uJ) / t (us) * 1e3, drawn as P mA at 1000 mV
+  uint32_t current = elapsedUs > 0 ? uint32_t(deltaUj * 1000 / elapsedUs) : 0;
+  return EnergySampler::Measurement{1000, current, double(deltaUj) / 1e6};
+}
+
+void RaplEnergyMeter::startSampling() {
+  if (sampler.isSampling()) {
+    return;
+  }
+  energyDeltaUj();
+  lastMeasured = EnergySampler::Clock::now();
+  sampler.start();
+}
+
+RaplEnergyMeter::Readings RaplEnergyMeter::stopSampling() {
+  return sampler.stop();
+}
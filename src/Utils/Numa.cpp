@@ -0,0 +1,222 @@
+#include <algorithm>
+#include <atomic>
+#include <barrier>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <string>
+#include <thread>
+
+#include "Utils/Logger.hpp"
+#include "Utils/Numa.hpp"
+
+using namespace GAMM;
+
+static std::optional<std::string> readLine(const std::filesystem::path &path) {
+  std::ifstream f{path};
+  std::string line;
+  if (!f || !std::getline(f, line)) {
+    return {};
+  }
+  return line;
+}
+
+std::vector<size_t> NumaTopology::parseCpuList(std::string_view list) {
+  std::vector<size_t> cpus;
+
+  while (!list.empty()) {
+    auto comma = list.find(',');
+    auto range = list.substr(0, comma);
+    list = (comma == std::string_view::npos) ? std::string_view{}
+                                             : list.substr(comma + 1);
+
+    // Strip the trailing newline or whitespace sysfs may leave behind
+    while (!range.empty() && std::isspace((unsigned char)range.back())) {
+      range.remove_suffix(1);
+    }
+    if (range.empty()) {
+      continue;
+    }
+
+    auto dash = range.find('-');
+    auto first = std::stoul(std::string{range.substr(0, dash)});
+    auto last = (dash == std::string_view::npos)
+                    ? first
+                    : std::stoul(std::string{range.substr(dash + 1)});
+    for (auto cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+
+  return cpus;
+}
+
+NumaTopology NumaTopology::discover(std::string_view sysPath) {
+  NumaTopology topology;
+  std::filesystem::path base{sysPath};
+
+  std::error_code ec;
+  for (const auto &entry :
+       std::filesystem::directory_iterator{base / "node", ec}) {
+    auto name = entry.path().filename().string();
+    if (name.rfind("node", 0) != 0 || name.size() == 4 ||
+        !std::all_of(name.begin() + 4, name.end(), ::isdigit)) {
+      continue;
+    }
+
+    auto cpulist = readLine(entry.path() / "cpulist");
+    if (!cpulist.has_value()) {
+      continue;
+    }
+
+    auto cpus = parseCpuList(cpulist.value());
+    // Memory-only nodes have no CPUs to place threads on
+    if (!cpus.empty()) {
+      topology.nodes.push_back({std::stoul(name.substr(4)), std::move(cpus)});
+    }
+  }
+
+  if (topology.nodes.empty()) {
+    auto online = readLine(base / "cpu" / "online");
+    std::vector<size_t> cpus;
+    if (online.has_value()) {
+      cpus = parseCpuList(online.value());
+    } else {
+      for (size_t i = 0; i < std::thread::hardware_concurrency(); ++i) {
+        cpus.push_back(i);
+      }
+    }
+    topology.nodes.push_back({0, std::move(cpus)});
+  }
+
+  std::sort(topology.nodes.begin(), topology.nodes.end(),
+            [](const Node &a, const Node &b) { return a.id < b.id; });
+
+  return topology;
+}
+
+size_t NumaTopology::ncpus() const noexcept {
+  size_t ret = 0;
+  for (const auto &node : nodes) {
+    ret += node.cpus.size();
+  }
+  return ret;
+}
+
+std::optional<size_t> NumaTopology::nodeOfCpu(size_t cpu) const noexcept {
+  for (const auto &node : nodes) {
+    if (std::find(node.cpus.begin(), node.cpus.end(), cpu) != node.cpus.end()) {
+      return node.id;
+    }
+  }
+  return {};
+}
+
+std::vector<size_t> NumaTopology::placement(size_t nthreads,
+                                            Placement placement) const {
+  std::vector<size_t> order;
+
+  if (placement == Placement::Compact) {
+    for (const auto &node : nodes) {
+      order.insert(order.end(), node.cpus.begin(), node.cpus.end());
+    }
+  } else {
+    // Round robin over the nodes, taking the next cpu of each in turn
+    for (size_t i = 0; order.size() < ncpus(); ++i) {
+      for (const auto &node : nodes) {
+        if (i < node.cpus.size()) {
+          order.push_back(node.cpus[i]);
+        }
+      }
+    }
+  }
+
+  std::vector<size_t> ret;
+  for (size_t i = 0; i < nthreads && !order.empty(); ++i) {
+    ret.push_back(order[i % order.size()]);
+  }
+  return ret;
+}
+
+std::optional<NumaTopology::Placement>
+NumaTopology::parsePlacement(std::string_view name) {
+  if (name == "compact") {
+    return Placement::Compact;
+  } else if (name == "scatter") {
+    return Placement::Scatter;
+  }
+  return {};
+}
+
+NumaTopology::PinScope::PinScope(std::optional<size_t> cpu) {
+  if (!cpu.has_value()) {
+    return;
+  }
+
+  cpu_set_t set;
+  if (pthread_getaffinity_np(pthread_self(), sizeof(set), &set) != 0) {
+    // Pinning without a mask to go back to would leave the thread pinned
+    INTELLI_WARNING("Cannot read the cpus of the calling thread, not pinning");
+    return;
+  }
+  previous = set;
+
+  if (!pinCurrentThread(cpu.value())) {
+    INTELLI_WARNING("Failed to pin calling thread to cpu " << cpu.value());
+  }
+}
+
+NumaTopology::PinScope::~PinScope() {
+  if (previous.has_value() &&
+      pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t),
+                             &previous.value()) != 0) {
+    INTELLI_WARNING("Failed to unpin calling thread");
+  }
+}
+
+bool NumaTopology::pinCurrentThread(size_t cpu) {
+  if (cpu >= CPU_SETSIZE) {
+    return false;
+  }
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+}
+
+void NumaTopology::pinPool(BS::thread_pool &pool,
+                           const std::vector<size_t> &cpus) {
+  INTELLI_ASSERT(!cpus.empty(), "No cpus to pin to");
+
+  auto nthreads = pool.get_thread_count();
+  if (nthreads == 0) {
+    return;
+  }
+
+  // Every task waits for all the others, so each one runs on a different
+  // thread of the pool
+  std::barrier<> barrier(nthreads);
+  std::atomic_size_t nextIndex{1};
+
+  BS::multi_future<void> tasks(nthreads);
+  for (size_t i = 0; i < nthreads; ++i) {
+    tasks[i] = pool.submit([&]() {
+      auto cpu = cpus[nextIndex.fetch_add(1) % cpus.size()];
+      if (!pinCurrentThread(cpu)) {
+        INTELLI_WARNING("Failed to pin pool thread to cpu " << cpu);
+      }
+      barrier.arrive_and_wait();
+    });
+  }
+  tasks.wait();
+}
+
+std::ostream &GAMM::operator<<(std::ostream &o, NumaTopology const &topology) {
+  o << "NumaTopology {";
+  for (const auto &node : topology.getNodes()) {
+    o << " node" << node.id << ": " << node.cpus.size() << " cpus;";
+  }
+  return o << " }";
+}
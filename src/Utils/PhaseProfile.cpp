@@ -0,0 +1,190 @@
+#include <algorithm>
+#include <bit>
+#include <iomanip>
+
+#include "Utils/PhaseProfile.hpp"
+
+using namespace GAMM;
+
+uint64_t PhaseProfile::Stats::quantileNs(double q) const noexcept {
+  auto rank = uint64_t(q * count);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < NBUCKETS; ++i) {
+    seen += histogram[i];
+    if (seen > rank) {
+      return i + 1 < NBUCKETS ? uint64_t{1} << (i + 1) : maxNs;
+    }
+  }
+  return maxNs;
+}
+
+static thread_local uint32_t currentLevel = 0;
+
+PhaseProfile::LevelScope::LevelScope(size_t level) noexcept
+    : previous{currentLevel} {
+  currentLevel = level;
+}
+
+PhaseProfile::LevelScope::~LevelScope() { currentLevel = previous; }
+
+static std::atomic_uint64_t nextProfileId{1};
+
+PhaseProfile::PhaseProfile() noexcept : id{nextProfileId++} {}
+
+PhaseProfile::Shard &PhaseProfile::localShard() {
+  // The last profile this thread recorded into, which is nearly always the
+  // next one too
+  static thread_local uint64_t cachedId = 0;
+  static thread_local Shard *cached = nullptr;
+  if (cachedId == id) {
+    return *cached;
+  }
+
+  auto self = std::this_thread::get_id();
+  const std::lock_guard<std::mutex> guard{mtx};
+  auto it = std::find_if(shards.begin(), shards.end(), [&](const auto &shard) {
+    return shard->owner == self;
+  });
+  if (it == shards.end()) {
+    shards.push_back(std::make_unique<Shard>());
+    shards.back()->owner = self;
+    it = shards.end() - 1;
+  }
+  cachedId = id;
+  cached = it->get();
+  return *cached;
+}
+
+void PhaseProfile::record(Phase phase, Clock::time_point start,
+                          Clock::time_point end) noexcept {
+  uint64_t ns =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+          .count();
+  auto bucket = std::min<size_t>(std::bit_width(ns | 1) - 1, NBUCKETS - 1);
+
+  Shard *shard;
+  try {
+    shard = &localShard();
+  } catch (const std::bad_alloc &) {
+    // Without a shard the phase goes unrecorded
+    return;
+  }
+
+  const std::lock_guard<std::mutex> guard{shard->mtx};
+  auto &s = shard->stats[size_t(phase)];
+  ++s.count;
+  s.totalNs += ns;
+  s.maxNs = std::max(s.maxNs, ns);
+  ++s.histogram[bucket];
+
+  if (markersEnabled.load(std::memory_order_relaxed) && !isSubphase(phase)) {
+    try {
+      shard->markers.push_back({start, end, phase, currentLevel});
+    } catch (const std::bad_alloc &) {
+      // Running out of memory for markers only loses the attribution
+      markersEnabled = false;
+    }
+  }
+}
+
+void PhaseProfile::reset() noexcept {
+  const std::lock_guard<std::mutex> guard{mtx};
+  for (auto &shard : shards) {
+    const std::lock_guard<std::mutex> shardGuard{shard->mtx};
+    shard->stats = {};
+    shard->markers.clear();
+  }
+}
+
+void PhaseProfile::setMarkers(bool enabled) noexcept {
+  const std::lock_guard<std::mutex> guard{mtx};
+  markersEnabled = enabled;
+  if (!enabled) {
+    for (auto &shard : shards) {
+      const std::lock_guard<std::mutex> shardGuard{shard->mtx};
+      shard->markers.clear();
+    }
+  }
+}
+
+std::vector<PhaseProfile::Marker> PhaseProfile::getMarkers() const {
+  std::vector<Marker> ret;
+  {
+    const std::lock_guard<std::mutex> guard{mtx};
+    for (const auto &shard : shards) {
+      const std::lock_guard<std::mutex> shardGuard{shard->mtx};
+      ret.insert(ret.end(), shard->markers.begin(), shard->markers.end());
+    }
+  }
+  std::sort(ret.begin(), ret.end(), [](const auto &a, const auto &b) {
+    return a.start < b.start;
+  });
+  return ret;
+}
+
+bool PhaseProfile::isSubphase(Phase phase) noexcept {
+  return phase == Phase::SweepPairs || phase == Phase::SweepRotations ||
+         phase == Phase::SweepApply;
+}
+
+PhaseProfile::Stats PhaseProfile::get(Phase phase) const {
+  Stats ret;
+  const std::lock_guard<std::mutex> guard{mtx};
+  for (const auto &shard : shards) {
+    const std::lock_guard<std::mutex> shardGuard{shard->mtx};
+    const auto &s = shard->stats[size_t(phase)];
+    ret.count += s.count;
+    ret.totalNs += s.totalNs;
+    ret.maxNs = std::max(ret.maxNs, s.maxNs);
+    for (size_t i = 0; i < NBUCKETS; ++i) {
+      ret.histogram[i] += s.histogram[i];
+    }
+  }
+  return ret;
+}
+
+std::string_view PhaseProfile::name(Phase phase) noexcept {
+  switch (phase) {
+  case Phase::Copy:
+    return "copy";
+  case Phase::Qr:
+    return "qr";
+  case Phase::Product:
+    return "product";
+  case Phase::Sweeps:
+    return "sweeps";
+  case Phase::SweepPairs:
+    return "  pairs";
+  case Phase::SweepRotations:
+    return "  rotations";
+  case Phase::SweepApply:
+    return "  apply";
+  case Phase::SvdFinish:
+    return "svd-finish";
+  case Phase::Shrink:
+    return "shrink";
+  case Phase::Update:
+    return "update";
+  }
+  return "unknown";
+}
+
+std::ostream &GAMM::operator<<(std::ostream &o, PhaseProfile const &profile) {
+  for (size_t i = 0; i < PhaseProfile::NPHASES; ++i) {
+    auto phase = PhaseProfile::Phase(i);
+    auto stats = profile.get(phase);
+    if (stats.count == 0) {
+      continue;
+    }
+
+    o << std::setw(14) << std::left << PhaseProfile::name(phase) << std::right
+      << std::setw(8) << stats.count << " x " << std::fixed
+      << std::setprecision(3) << std::setw(10) << stats.totalNs / 1e6
+      << "ms, mean " << std::setw(9) << stats.totalNs / 1e3 / stats.count
+      << "us, p50 < " << std::setw(9) << stats.quantileNs(0.5) / 1e3
+      << "us, p99 < " << std::setw(9) << stats.quantileNs(0.99) / 1e3
+      << "us\n"
+      << std::defaultfloat;
+  }
+  return o;
+}
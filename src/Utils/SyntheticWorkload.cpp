@@ -0,0 +1,80 @@
+#include <algorithm>
+#include <cmath>
+#include <numbers>
+
+#include "Utils/SyntheticWorkload.hpp"
+
+using namespace GAMM;
+
+std::pair<Matrix, Matrix>
+SyntheticWorkload::generate(const Options &options) {
+  UtilityFunctions::init_genrand(options.seed);
+
+  auto rank = std::min({options.rank, options.xRows, options.yRows,
+                        options.cols});
+  auto correlation = std::clamp<scalar_t>(options.correlation, 0, 1);
+
+  Vector spectrum{rank};
+  for (size_t i = 0; i < rank; ++i) {
+    spectrum[i] = std::pow(scalar_t(i + 1), -options.decay);
+  }
+  // Scale the signal so that its entries have unit variance
+  if (rank > 0) {
+    spectrum /= spectrum.norm();
+  }
+
+  Matrix xCoords = gaussian(options.cols, rank);
+  Matrix yCoords = correlation * xCoords +
+                   std::sqrt(1 - correlation * correlation) *
+                       gaussian(options.cols, rank);
+
+  Matrix x = gaussian(options.xRows, rank) * spectrum.asDiagonal() *
+             xCoords.transpose();
+  Matrix y = gaussian(options.yRows, rank) * spectrum.asDiagonal() *
+             yCoords.transpose();
+
+  addNoiseAndDrop(x, options);
+  addNoiseAndDrop(y, options);
+
+  return {std::move(x), std::move(y)};
+}
+
+scalar_t SyntheticWorkload::gaussian() {
+  auto u1 = UtilityFunctions::genrand_real3();
+  auto u2 = UtilityFunctions::genrand_real3();
+  return std::sqrt(-2 * std::log(u1)) * std::cos(2 * std::numbers::pi * u2);
+}
+
+Matrix SyntheticWorkload::gaussian(size_t rows, size_t cols) {
+  Matrix m{rows, cols};
+  for (auto &entry : m.reshaped()) {
+    entry = gaussian();
+  }
+  return m;
+}
+
+void SyntheticWorkload::addNoiseAndDrop(Matrix &m, const Options &options) {
+  if (options.noise > 0) {
+    for (auto &entry : m.reshaped()) {
+      entry += options.noise * gaussian();
+    }
+  }
+
+  if (options.density < 1) {
+    for (auto &entry : m.reshaped()) {
+      if (UtilityFunctions::genrand_real3() >= options.density) {
+        entry = 0;
+      }
+    }
+  }
+}
+
+std::ostream &GAMM::operator<<(std::ostream &o,
+                               SyntheticWorkload::Options const &options) {
+  return o << "{ x: (" << options.xRows << ", " << options.cols << "), y: ("
+           << options.yRows << ", " << options.cols
+           << "), rank: " << options.rank << ", decay: " << options.decay
+           << ", noise: " << options.noise << ", density: " << options.density
+           << ", correlation: " << options.correlation
+           << ", seed: " << options.seed << " }";
+}
@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+#include <unistd.h>
+
+#include "Utils/Logger.hpp"
+#include "Utils/Tracer.hpp"
+
+using namespace GAMM;
+
+std::atomic_bool Tracer::isEnabled{false};
+std::string Tracer::outputPath;
+size_t Tracer::bufferCapacity;
+Tracer::Clock::time_point Tracer::origin;
+std::mutex Tracer::buffersMutex;
+std::vector<std::shared_ptr<Tracer::Buffer>> Tracer::buffers;
+
+void Tracer::enable(std::string path, size_t capacity) {
+  if (enabled()) {
+    return;
+  }
+  outputPath = std::move(path);
+  bufferCapacity = capacity;
+  origin = Clock::now();
+  std::atexit(writeAtExit);
+  isEnabled.store(true, std::memory_order_relaxed);
+}
+
+Tracer::Buffer *Tracer::threadBuffer() {
+  // The buffer is kept until the trace is written, so only its events are
+  // kept once the thread exits
+  struct Holder {
+    std::shared_ptr<Buffer> buffer;
+    ~Holder() {
+      if (buffer) {
+        const std::lock_guard<std::mutex> guard{buffersMutex};
+        buffer->events.resize(buffer->size.load(std::memory_order_relaxed));
+        buffer->events.shrink_to_fit();
+      }
+    }
+  };
+
+  thread_local Holder holder;
+  auto &buffer = holder.buffer;
+  if (!buffer) {
+    buffer = std::make_shared<Buffer>();
+    buffer->events.resize(std::min(INITIAL_CAPACITY, bufferCapacity));
+
+    const std::lock_guard<std::mutex> guard{buffersMutex};
+    buffer->tid = buffers.size();
+    buffers.push_back(buffer);
+  }
+  return buffer.get();
+}
+
+void Tracer::record(const char *name, Clock::time_point start,
+                    Clock::time_point end, int64_t arg) noexcept {
+  Buffer *buffer;
+  try {
+    buffer = threadBuffer();
+  } catch (const std::bad_alloc &) {
+    return;
+  }
+
+  // Only this thread writes to its buffer, the release publishes the event to
+  // write
+  auto n = buffer->size.load(std::memory_order_relaxed);
+  if (n == buffer->events.size()) {
+    bool grown = false;
+    if (n < bufferCapacity) {
+      try {
+        const std::lock_guard<std::mutex> guard{buffersMutex};
+        buffer->events.resize(std::min(2 * n, bufferCapacity));
+        grown = true;
+      } catch (const std::bad_alloc &) {
+      }
+    }
+    if (!grown) {
+      buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+  }
+  auto ns = [](Clock::duration d) {
+    return uint64_t(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+  };
+  buffer->events[n] = {name, ns(start - origin), ns(end - start), arg};
+  buffer->size.store(n + 1, std::memory_order_release);
+}
+
+bool Tracer::write(const std::string &path) {
+  std::ofstream f{path};
+  if (!f) {
+    INTELLI_ERROR("Failed to open trace file " << path);
+    return false;
+  }
+
+  auto pid = getpid();
+  f << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+  f << "{\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << pid
+    << ", \"args\": {\"name\": \"gamm\"}}";
+
+  const std::lock_guard<std::mutex> guard{buffersMutex};
+  size_t total = 0;
+  f << std::fixed << std::setprecision(3);
+  for (const auto &buffer : buffers) {
+    f << ",\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": " << pid
+      << ", \"tid\": " << buffer->tid << ", \"args\": {\"name\": \"thread "
+      << buffer->tid << "\", \"dropped\": "
+      << buffer->dropped.load(std::memory_order_relaxed) << "}}";
+
+    auto n = buffer->size.load(std::memory_order_acquire);
+    for (size_t i = 0; i < n; ++i) {
+      const auto &event = buffer->events[i];
+      f << ",\n{\"name\": \"" << event.name
+        << "\", \"cat\": \"gamm\", \"ph\": \"X\", \"ts\": "
+        << event.startNs / 1e3 << ", \"dur\": " << event.durationNs / 1e3
+        << ", \"pid\": " << pid << ", \"tid\": " << buffer->tid;
+      if (event.arg != NO_ARG) {
+        f << ", \"args\": {\"arg\": " << event.arg << "}";
+      }
+      f << "}";
+    }
+    total += n;
+  }
+  f << "\n]}\n";
+
+  INTELLI_INFO("Wrote " << total << " trace events of " << buffers.size()
+                        << " threads to " << path);
+  return bool(f);
+}
+
+void Tracer::writeAtExit() { write(outputPath); }
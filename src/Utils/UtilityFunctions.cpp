@@ -106,6 +106,21 @@ scalar_t UtilityFunctions::spectralNorm(const Matrix &mat) {
   return svd.singularValues().diagonal()[0];
 }
 
+SparseRef UtilityFunctions::sparseRef(const SparseMatrix &mat) {
+  INTELLI_ASSERT(mat.isCompressed(), "Sparse inputs must be compressed");
+  return SparseRef(mat.rows(), mat.cols(), mat.nonZeros(), mat.outerIndexPtr(),
+                   mat.innerIndexPtr(), mat.valuePtr());
+}
+
+SparseRef UtilityFunctions::sparseCols(const SparseRef &mat, size_t start,
+                                       size_t n) {
+  // The outer indices are offsets into the whole inner index and value
+  // arrays, so the columns only need their own slice of the outer indices
+  auto outer = mat.outerIndexPtr() + start;
+  return SparseRef(mat.rows(), n, outer[n] - outer[0], outer,
+                   mat.innerIndexPtr(), mat.valuePtr());
+}
+
 #if defined(__GNUC__) && defined(__cplusplus)
 uint64_t UtilityFunctions::trailingZeros(uint64_t n) {
   return __builtin_ctzll(n);
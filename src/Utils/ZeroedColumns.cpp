@@ -9,6 +9,7 @@ void ZeroedColumns::resizeFilled(size_t size) {
   nextZeroed.clear();
   nextZeroed.resize(size, NON_ZERO);
   head = size;
+  zeroedCount = 0;
 }
 
 void ZeroedColumns::resizeEmpty(size_t size) {
@@ -22,7 +23,9 @@ void ZeroedColumns::resizeEmpty(size_t size) {
 
 void ZeroedColumns::fromMatrix(const Matrix &matrix) {
   resizeFilled(matrix.cols());
-  for (int i = 0; i < matrix.cols(); ++i) {
+  // Walk backwards so that the zeroed columns are handed out in ascending
+  // order, the same as after resizeEmpty
+  for (int i = matrix.cols() - 1; i >= 0; --i) {
     auto isZero =
         matrix.col(i).unaryExpr(std::ref(UtilityFunctions::isZero)).all();
     // std::cout << "Index " << i << " is zero? " << isZero << "\n";
@@ -34,10 +37,8 @@ void ZeroedColumns::fromMatrix(const Matrix &matrix) {
 
 void ZeroedColumns::setZeroed(size_t index) {
   if (nextZeroed[index] != NON_ZERO) {
-    // INTELLI_WARNING("Setting already zeroed column (" << index << ") to zero");
-    // Reduce zeroedCount so that increment later will restore it to the same
-    // count
-    zeroedCount--;
+    // Already part of the list. Linking it again would create a cycle
+    return;
   }
 
   nextZeroed[index] = head;
@@ -0,0 +1,84 @@
+// Copyright (C) 2023 by the INTELLI team (https://github.com/intellistream)
+
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <optional>
+#include <string>
+#include <unistd.h>
+
+#include <Utils/Logger.hpp>
+#include <Utils/Meter/RaplEnergyMeter.hpp>
+
+namespace fs = std::filesystem;
+
+// A powercap tree with two packages, a DRAM and a core subzone, a psys zone
+// and a package whose energy range is missing
+class RaplEnergyMeterTest : public ::testing::Test {
+protected:
+  void SetUp() override {
+    setupLogging("benchmark.log", LOG_DEBUG);
+
+    base = fs::temp_directory_path() /
+           ("gamm-rapl-" + std::to_string(getpid()));
+    fs::remove_all(base);
+    addZone("intel-rapl:0", "package-0", 500, "1000");
+    addZone("intel-rapl:0:0", "dram", 10, "1000");
+    addZone("intel-rapl:0:1", "core", 0, "1000");
+    addZone("intel-rapl:1", "package-1", 0, "1000");
+    addZone("intel-rapl:2", "psys", 0, "1000");
+    addZone("intel-rapl:3", "package-3", 5, {});
+  }
+
+  void TearDown() override { fs::remove_all(base); }
+
+  void addZone(const std::string &zone, const std::string &name,
+               uint64_t energyUj, std::optional<std::string> maxEnergyUj) {
+    fs::create_directories(base / zone);
+    std::ofstream{base / zone / "name"} << name << "\n";
+    setEnergy(zone, energyUj);
+    if (maxEnergyUj.has_value()) {
+      std::ofstream{base / zone / "max_energy_range_uj"}
+          << maxEnergyUj.value() << "\n";
+    }
+  }
+
+  // The meter keeps the file open and reads it again from the start
+  void setEnergy(const std::string &zone, uint64_t energyUj) {
+    std::ofstream{base / zone / "energy_uj"} << energyUj << "\n";
+  }
+
+  fs::path base;
+};
+
+TEST_F(RaplEnergyMeterTest, SumsPackagesAndDramAcrossWraps) {
+  ASSERT_TRUE(GAMM::RaplEnergyMeter::canBeUsed(base.string()));
+
+  GAMM::RaplEnergyMeter meter{std::chrono::milliseconds(1), base.string()};
+  meter.startSampling();
+
+  setEnergy("intel-rapl:0", 900);
+  setEnergy("intel-rapl:0:0", 30);
+  setEnergy("intel-rapl:0:1", 400);
+  setEnergy("intel-rapl:1", 250);
+  setEnergy("intel-rapl:2", 800);
+  // Going down without a known range must not count as a wrap
+  setEnergy("intel-rapl:3", 3);
+  usleep(5000);
+  // Wraps around at 1000, adding 200
+  setEnergy("intel-rapl:0", 100);
+  usleep(5000);
+
+  auto readings = meter.stopSampling();
+
+  // 600 for package 0, 20 for the DRAM and 250 for package 1
+  EXPECT_NEAR(readings.energyConsumed(), 870e-6, 1e-12);
+}
+
+TEST_F(RaplEnergyMeterTest, NeedsAReadableZone) {
+  fs::remove_all(base);
+  addZone("intel-rapl:0", "package-0", 5, "not a number");
+
+  EXPECT_FALSE(GAMM::RaplEnergyMeter::canBeUsed(base.string()));
+}